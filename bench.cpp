@@ -0,0 +1,619 @@
+/*
+Headless benchmarks of the simulation.
+	bench [name...]
+Runs every benchmark when no name is given.
+*/
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include "gravity.hpp"
+#include "integrator.hpp"
+#include "jobs.hpp"
+#include "kepler.hpp"
+#include "landing.hpp"
+#include "soi.hpp"
+#include "terrain.hpp"
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//`n` bodies uniform in a ball
+static void fill_bodies(GravityEngine *engine, int n, float radius, unsigned int seed) {
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+
+	for (int i = 0; i < n; i++) {
+		glm::vec3 p;
+		do {
+			p = glm::vec3(uniform(rng), uniform(rng), uniform(rng));
+		} while (glm::dot(p, p) > 1.0f);
+
+		engine->add_body(p * radius, glm::vec3(0.0f), 1.0f + uniform(rng) * 0.5f);
+	}
+}
+
+static const IntegratorType INTEGRATOR_TYPES[] = {
+	IntegratorType::SEMI_IMPLICIT_EULER,
+	IntegratorType::VELOCITY_VERLET,
+	IntegratorType::RK4,
+	IntegratorType::FOREST_RUTH,
+};
+
+/*
+Energy/angular momentum drift per integrator and step size, on an eccentric orbit like the ones around the planet.
+For each integrator, reports the largest step that keeps the energy drift under `BUDGET`.
+*/
+static void bench_drift() {
+	const float GM = 320.0f; //The planet: 2.56 * 5^3
+	const float PERIAPSIS = 8.0f;
+	const float ECCENTRICITY = 0.5f;
+	const float ORBITS = 20.0f;
+	const double BUDGET = 1e-4;
+	const float HZS[] = {30, 60, 120, 240, 480, 960};
+
+	printf("== drift (GM %.0f, periapsis %.1f, e %.2f, %.0f orbits, budget %.0e)\n", GM, PERIAPSIS, ECCENTRICITY, ORBITS, BUDGET);
+	printf("%-20s %6s %12s %12s %10s\n", "integrator", "hz", "energy", "ang. mom.", "ns/step");
+
+	for (IntegratorType type : INTEGRATOR_TYPES) {
+		Integrator *integrator = new_integrator(type);
+		float best_hz = -1;
+
+		for (float hz : HZS) {
+			DriftReport report = measure_drift(integrator, GM, PERIAPSIS, ECCENTRICITY, 1.0f / hz, ORBITS);
+			printf("%-20s %6.0f %12.3e %12.3e %10.1f\n",
+				get_integrator_name(type), hz, report.energy_drift, report.angular_momentum_drift, report.seconds * 1e9 / report.steps);
+
+			if (best_hz < 0 && report.energy_drift < BUDGET)
+				best_hz = hz;
+		}
+
+		if (best_hz < 0)
+			printf("%-20s no step within the budget\n", get_integrator_name(type));
+		else
+			printf("%-20s largest step within the budget: 1/%.0f s\n", get_integrator_name(type), best_hz);
+
+		delete integrator;
+	}
+}
+
+/*
+Direct O(N^2) sum, SIMD against scalar.
+Large N time only a slice of the targets (against all sources) and scale.
+*/
+static void bench_gravity() {
+	const int NS[] = {10, 100, 1000, 10000, 100000};
+	const long long INTERACTIONS = 200000000; //Per measurement
+
+	printf("== gravity (simd: %s)\n", GravityEngine::get_simd_name());
+	printf("%8s %16s %16s %8s %12s\n", "n", "scalar int/s", "simd int/s", "speedup", "max rel err");
+
+	for (int n : NS) {
+		GravityEngine engine;
+		fill_bodies(&engine, n, 100.0f, 1);
+
+		int targets = (int) std::min<long long>(n, std::max<long long>(1, INTERACTIONS / n));
+		int repeats = (int) std::max<long long>(1, INTERACTIONS / ((long long) targets * n));
+		double interactions = (double) targets * n * repeats;
+
+		engine.set_kernel(GravityKernel::SCALAR);
+		auto start = std::chrono::steady_clock::now();
+		for (int r = 0; r < repeats; r++)
+			engine.compute_accelerations(0, targets);
+		double scalar_rate = interactions / seconds_since(start);
+
+		std::vector<glm::vec3> reference(targets);
+		for (int i = 0; i < targets; i++)
+			reference[i] = engine.get_acceleration(i);
+
+		engine.set_kernel(GravityKernel::SIMD);
+		start = std::chrono::steady_clock::now();
+		for (int r = 0; r < repeats; r++)
+			engine.compute_accelerations(0, targets);
+		double simd_rate = interactions / seconds_since(start);
+
+		double max_error = 0.0;
+		for (int i = 0; i < targets; i++) {
+			double error = glm::length(engine.get_acceleration(i) - reference[i]) / glm::length(reference[i]);
+			max_error = std::max(max_error, error);
+		}
+
+		printf("%8d %16.3e %16.3e %8.2f %12.3e\n", n, scalar_rate, simd_rate, simd_rate / scalar_rate, max_error);
+	}
+}
+
+/*
+Barnes-Hut against the direct sum: tree build time, test particles per second and the error on a sample.
+*/
+static void bench_octree() {
+	const int NS[] = {10000, 100000};
+	const float THETAS[] = {0.3f, 0.5f, 0.7f, 1.0f};
+	const int PARTICLES = 1000000;
+	const int SAMPLE = 1000; //For the error, against the direct sum
+
+	printf("== octree (%d test particles, error on %d)\n", PARTICLES, SAMPLE);
+	printf("%8s %6s %10s %10s %14s %12s %12s\n", "n", "theta", "build ms", "pass ms", "particles/s", "median err", "max err");
+
+	std::mt19937 rng(2);
+	std::uniform_real_distribution<float> uniform(-150.0f, 150.0f);
+	std::vector<glm::vec3> particles(PARTICLES), accelerations(PARTICLES);
+	for (glm::vec3 &p : particles)
+		p = glm::vec3(uniform(rng), uniform(rng), uniform(rng));
+
+	for (int n : NS) {
+		GravityEngine engine;
+		fill_bodies(&engine, n, 100.0f, 1);
+
+		std::vector<glm::vec3> reference(SAMPLE);
+		for (int i = 0; i < SAMPLE; i++)
+			reference[i] = glm::vec3(engine.get_gravity(glm::dvec3(particles[i]), 0.0));
+
+		for (float theta : THETAS) {
+			engine.set_mode(GravityMode::BARNES_HUT, theta);
+
+			//Moving a body invalidates the tree; the first query rebuilds it
+			engine.set_position(0, engine.get_position(0));
+			auto start = std::chrono::steady_clock::now();
+			engine.get_gravity(glm::dvec3(particles[0]), 0.0);
+			double build = seconds_since(start);
+
+			start = std::chrono::steady_clock::now();
+			engine.get_gravity(particles.data(), accelerations.data(), PARTICLES);
+			double pass = seconds_since(start);
+
+			std::vector<double> errors(SAMPLE);
+			for (int i = 0; i < SAMPLE; i++)
+				errors[i] = glm::length(accelerations[i] - reference[i]) / glm::length(reference[i]);
+			std::sort(errors.begin(), errors.end());
+
+			printf("%8d %6.2f %10.2f %10.1f %14.3e %12.3e %12.3e\n",
+				n, theta, build * 1e3, pass * 1e3, PARTICLES / pass, errors[SAMPLE / 2], errors[SAMPLE - 1]);
+		}
+	}
+}
+
+//FNV-1a over the bits of the state, for bit-for-bit comparisons
+static unsigned long long hash_engine(GravityEngine *engine) {
+	unsigned long long hash = 14695981039346656037ULL;
+	for (int i = 0; i < engine->get_count(); i++) {
+		glm::vec3 values[2] = {engine->get_position(i), engine->get_velocity(i)};
+		const unsigned char *bytes = (const unsigned char *) values;
+		for (size_t b = 0; b < sizeof values; b++)
+			hash = (hash ^ bytes[b]) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+/*
+Scaling of a direct N-body step and a Barnes-Hut test particle pass over the thread count.
+The state after the steps must hash the same for every thread count.
+*/
+static void bench_jobs() {
+	const int THREADS[] = {1, 2, 4, 8, 16, 32, 64};
+	const int N = 8192;
+	const int STEPS = 4;
+	const int PARTICLES = 1000000;
+
+	printf("== jobs (%u cores; direct: %d bodies x %d steps; barnes-hut: %d particles)\n", std::thread::hardware_concurrency(), N, STEPS, PARTICLES);
+	printf("%8s %12s %8s %12s %8s %18s %6s\n", "threads", "step ms", "speedup", "bh pass ms", "speedup", "hash", "same");
+
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<float> uniform(-150.0f, 150.0f);
+	std::vector<glm::vec3> particles(PARTICLES), accelerations(PARTICLES);
+	for (glm::vec3 &p : particles)
+		p = glm::vec3(uniform(rng), uniform(rng), uniform(rng));
+
+	double base_step = 0.0, base_pass = 0.0;
+	unsigned long long base_hash = 0;
+	for (int threads : THREADS) {
+		JobSystem jobs(threads);
+
+		GravityEngine engine(0.1f);
+		fill_bodies(&engine, N, 100.0f, 1);
+		engine.set_jobs(&jobs);
+
+		auto start = std::chrono::steady_clock::now();
+		for (int s = 0; s < STEPS; s++)
+			engine.step(0.01f);
+		double step = seconds_since(start) / STEPS;
+		unsigned long long hash = hash_engine(&engine);
+
+		engine.set_mode(GravityMode::BARNES_HUT, 0.5f);
+		engine.get_gravity(particles.data(), accelerations.data(), 1); //Builds the tree
+		start = std::chrono::steady_clock::now();
+		engine.get_gravity(particles.data(), accelerations.data(), PARTICLES);
+		double pass = seconds_since(start);
+
+		if (threads == 1) {
+			base_step = step;
+			base_pass = pass;
+			base_hash = hash;
+		}
+		printf("%8d %12.2f %8.2f %12.2f %8.2f %18llx %6s\n",
+			threads, step * 1e3, base_step / step, pass * 1e3, base_pass / pass, hash, (hash == base_hash) ? "yes" : "NO");
+	}
+}
+
+//Kepler's equation in double, to convergence
+static glm::dvec3 get_orbit_position_exact(const OrbitalElements &el, double time) {
+	double e = el.eccentricity;
+	double m = std::fmod(el.mean_anomaly + el.mean_motion * time, 2 * 3.14159265358979323846);
+	double ecc_anomaly = m + e * std::sin(m);
+	for (int i = 0; i < 50; i++)
+		ecc_anomaly -= (ecc_anomaly - e * std::sin(ecc_anomaly) - m) / (1 - e * std::cos(ecc_anomaly));
+
+	double cn = std::cos(el.ascending_node), sn = std::sin(el.ascending_node);
+	double cw = std::cos(el.argument_of_periapsis), sw = std::sin(el.argument_of_periapsis);
+	double ci = std::cos(el.inclination), si = std::sin(el.inclination);
+	glm::dvec3 p(cn*cw - sn*sw*ci, sw*si, sn*cw + cn*sw*ci);
+	glm::dvec3 q(-cn*sw - sn*cw*ci, cw*si, -sn*sw + cn*cw*ci);
+
+	double a = el.semi_major_axis, b = a * std::sqrt(1 - e*e);
+	return p * (a * (std::cos(ecc_anomaly) - e)) + q * (b * std::sin(ecc_anomaly));
+}
+
+/*
+Batched Kepler propagation: cold and warm (frame to frame) updates, error against a double precision solve.
+*/
+static void bench_kepler() {
+	const int NS[] = {1000, 10000, 100000};
+	const int FRAMES = 600;
+	const float FRAME_TIME = 1.0f / 60;
+
+	printf("== kepler (%d frames of %.4f s)\n", FRAMES, FRAME_TIME);
+	printf("%8s %10s %10s %12s %14s\n", "n", "cold ms", "warm ms", "ns/orbit", "max err / a");
+
+	for (int n : NS) {
+		std::mt19937 rng(4);
+		std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+		KeplerBatch batch;
+		std::vector<OrbitalElements> orbits(n);
+		for (OrbitalElements &el : orbits) {
+			el.semi_major_axis = 10.0f + 1000.0f * uniform(rng);
+			el.eccentricity = 0.9f * uniform(rng);
+			el.inclination = 3.1415926f * uniform(rng);
+			el.ascending_node = 6.2831853f * uniform(rng);
+			el.argument_of_periapsis = 6.2831853f * uniform(rng);
+			el.mean_anomaly = 6.2831853f * uniform(rng);
+			el.mean_motion = 0.01f + 2.0f * uniform(rng);
+			batch.add(el);
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		batch.update(0.0f);
+		double cold = seconds_since(start);
+
+		start = std::chrono::steady_clock::now();
+		for (int f = 1; f <= FRAMES; f++)
+			batch.update(f * FRAME_TIME);
+		double warm = seconds_since(start) / FRAMES;
+
+		double max_error = 0.0;
+		for (int i = 0; i < n; i++) {
+			glm::dvec3 exact = get_orbit_position_exact(orbits[i], (double) (FRAMES * FRAME_TIME));
+			double error = glm::length(glm::dvec3(batch.get_position(i)) - exact) / orbits[i].semi_major_axis;
+			max_error = std::max(max_error, error);
+		}
+
+		printf("%8d %10.3f %10.3f %12.2f %14.3e\n", n, cold * 1e3, warm * 1e3, warm * 1e9 / n, max_error);
+	}
+}
+
+//Every body of a `SoiSystem` pulling as placed, summed directly: what patched conics avoid
+class DirectField : public GravityField {
+public:
+	DirectField(SoiSystem *system) : system(system) {}
+
+	void place(double time) {
+		system->update(time);
+		int n = system->get_count();
+		int padded = (n + GRAVITY_PADDING - 1) / GRAVITY_PADDING * GRAVITY_PADDING;
+		x.assign(padded, 0.0f);
+		y.assign(padded, 0.0f);
+		z.assign(padded, 0.0f);
+		gm.assign(padded, 0.0f);
+		for (int i = 0; i < n; i++) {
+			glm::dvec3 p, v, a;
+			system->get_body_state(i, time, &p, &v, &a);
+			x[i] = (float) p.x;
+			y[i] = (float) p.y;
+			z[i] = (float) p.z;
+			gm[i] = system->get_gm(i);
+		}
+	}
+
+	//`time` is ignored, as in `GravityEngine`
+	glm::dvec3 get_gravity(glm::dvec3 target, double time) override {
+		return glm::dvec3(accumulate_gravity(GravityKernel::SIMD, x.data(), y.data(), z.data(), gm.data(), (int) x.size(), glm::vec3(target), 0.0f));
+	}
+
+private:
+	SoiSystem *system;
+	std::vector<float> x, y, z, gm;
+};
+
+/*
+Patched conics against the direct sum, as the number of bodies grows: a sun, planets and 7 moons each.
+Ships start around random planets, some fast enough to leave; each is stepped with its own Verlet integrator.
+Reports the cost per ship step and, at the start, the error of the acceleration against the direct sum.
+*/
+static void bench_soi() {
+	const int PLANETS[] = {2, 16, 128, 1024};
+	const int MOONS = 7;
+	const int SHIPS = 2000;
+	const int STEPS = 400;
+	const float STEP = 0.05f;
+	const float SUN_GM = 1e6f;
+
+	printf("== soi (%d ships x %d steps of %.2f s)\n", SHIPS, STEPS, STEP);
+	printf("%8s %10s %12s %12s %12s %12s %12s %12s\n",
+		"bodies", "place us", "direct ns", "soi ns", "perturb ns", "soi err", "perturb err", "transitions");
+
+	for (int planets : PLANETS) {
+		std::mt19937 rng(6);
+		std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+		std::normal_distribution<float> normal(0.0f, 1.0f);
+
+		SoiSystem system(SUN_GM);
+		std::vector<int> planet_bodies;
+		for (int p = 0; p < planets; p++) {
+			OrbitalElements orbit = {};
+			orbit.semi_major_axis = 1000.0f * std::pow(4.0f, uniform(rng));
+			orbit.eccentricity = 0.1f * uniform(rng);
+			orbit.inclination = 0.1f * uniform(rng);
+			orbit.ascending_node = 6.2831853f * uniform(rng);
+			orbit.mean_anomaly = 6.2831853f * uniform(rng);
+			orbit.mean_motion = std::sqrt(SUN_GM / (orbit.semi_major_axis * orbit.semi_major_axis * orbit.semi_major_axis));
+			float gm = SUN_GM * std::pow(10.0f, -5.0f + 2.0f * uniform(rng));
+			int planet = system.add_body(0, gm, orbit);
+			planet_bodies.push_back(planet);
+
+			for (int m = 0; m < MOONS; m++) {
+				OrbitalElements moon = {};
+				moon.semi_major_axis = system.get_soi_radius(planet) * glm::mix(0.1f, 0.4f, uniform(rng));
+				moon.inclination = 3.1415926f * uniform(rng);
+				moon.ascending_node = 6.2831853f * uniform(rng);
+				moon.mean_anomaly = 6.2831853f * uniform(rng);
+				moon.mean_motion = std::sqrt(gm / (moon.semi_major_axis * moon.semi_major_axis * moon.semi_major_axis));
+				system.add_body(planet, gm * std::pow(10.0f, -3.0f + 1.5f * uniform(rng)), moon);
+			}
+		}
+
+		//Around a planet, from half to 1.5 times the circular speed
+		system.update(0.0);
+		std::vector<BodyState> starts(SHIPS);
+		std::vector<int> start_bodies(SHIPS);
+		for (int i = 0; i < SHIPS; i++) {
+			int planet = planet_bodies[i % planets];
+			glm::dvec3 p, v, a;
+			system.get_body_state(planet, 0.0, &p, &v, &a);
+
+			glm::vec3 out = glm::normalize(glm::vec3(normal(rng), normal(rng), normal(rng)));
+			glm::vec3 side = glm::normalize(glm::cross(out, glm::vec3(normal(rng), normal(rng), normal(rng))));
+			float dist = system.get_soi_radius(planet) * glm::mix(0.3f, 0.9f, uniform(rng));
+			float speed = std::sqrt(system.get_gm(planet) / dist) * glm::mix(0.5f, 1.5f, uniform(rng));
+			starts[i] = {p + glm::dvec3(out * dist), v + glm::dvec3(side * speed)};
+			start_bodies[i] = system.find_dominant(starts[i].position, 0.0, planet);
+		}
+
+		//Error against the direct sum, at the start
+		DirectField direct(&system);
+		direct.place(0.0);
+		std::vector<double> errors[2];
+		for (int i = 0; i < SHIPS; i++) {
+			glm::dvec3 reference = direct.get_gravity(starts[i].position, 0.0);
+			for (int k = 0; k < 2; k++) {
+				glm::dvec3 accel = system.get_gravity(start_bodies[i], starts[i].position, 0.0, k == 1);
+				errors[k].push_back(glm::length(accel - reference) / glm::length(reference));
+			}
+		}
+		for (std::vector<double> &e : errors)
+			std::sort(e.begin(), e.end());
+
+		//Bodies are placed at the end of each step, where Verlet evaluates
+		auto run = [&](GravityField *field, int mode, int *transitions) {
+			std::vector<BodyState> states = starts;
+			std::vector<Integrator *> integrators(SHIPS);
+			std::vector<SoiField> fields;
+			for (int i = 0; i < SHIPS; i++) {
+				integrators[i] = new_integrator(IntegratorType::VELOCITY_VERLET);
+				fields.emplace_back(&system, start_bodies[i]);
+				fields.back().set_perturbations(mode == 2);
+			}
+
+			//Summed as Verlet does, so the placement matches its times bit for bit
+			double time = 0.0;
+			double placing = 0.0;
+			auto start = std::chrono::steady_clock::now();
+			for (int s = 0; s < STEPS; s++) {
+				double next = time + STEP;
+				auto place_start = std::chrono::steady_clock::now();
+				if (mode == 0)
+					direct.place(next);
+				else
+					system.update(next);
+				placing += seconds_since(place_start);
+
+				for (int i = 0; i < SHIPS; i++) {
+					if (mode == 0) {
+						integrators[i]->step(&states[i], time, STEP, field);
+					}
+					else {
+						integrators[i]->step(&states[i], time, STEP, &fields[i]);
+						fields[i].update(states[i], next);
+					}
+				}
+				time = next;
+			}
+			double total = seconds_since(start);
+
+			*transitions = 0;
+			for (int i = 0; i < SHIPS; i++) {
+				*transitions += (int) fields[i].get_events().size();
+				delete integrators[i];
+			}
+			return std::make_pair(placing / STEPS, (total - placing) / ((double) SHIPS * STEPS));
+		};
+
+		int transitions, perturbed_transitions;
+		auto direct_cost = run(&direct, 0, &transitions);
+		auto soi_cost = run(nullptr, 1, &transitions);
+		auto perturbed_cost = run(nullptr, 2, &perturbed_transitions);
+
+		printf("%8d %10.2f %12.1f %12.1f %12.1f %12.3e %12.3e %5d / %5d\n",
+			system.get_count(), soi_cost.first * 1e6, direct_cost.second * 1e9, soi_cost.second * 1e9, perturbed_cost.second * 1e9,
+			errors[0][SHIPS / 2], errors[1][SHIPS / 2], transitions, perturbed_transitions);
+	}
+}
+
+//A non-rotating planet of radius `RADIUS` with the terrain
+class TerrainSurface : public Surface {
+public:
+	static constexpr float RADIUS = 5.0f;
+
+	TerrainSurface(Terrain *terrain) : terrain(terrain) {}
+
+	float get_max_radius() override {
+		float min, max;
+		terrain->get_height_range(glm::vec3(0.0f, 1.0f, 0.0f), 3.1415926f, &min, &max);
+		return to_radius(max);
+	}
+
+	float get_max_radius(glm::vec3 direction, float angle) override {
+		float min, max;
+		terrain->get_height_range(direction, angle, &min, &max);
+		return to_radius(max);
+	}
+
+	float get_radius(glm::vec3 position, float s) override {
+		return to_radius(terrain->get_height(position));
+	}
+
+	float get_feature_angle() override {
+		return terrain->get_texel_angle();
+	}
+
+private:
+	float to_radius(float height) {
+		return RADIUS * (1.0f + MARS_RELIEF * (height - 0.5f));
+	}
+
+	Terrain *terrain;
+};
+
+/*
+Terrain of the planet: building it from the bump map, point and range queries,
+and sweeping the ship over a step against it versus against the bare sphere.
+*/
+static void bench_terrain() {
+	const int QUERIES = 1000000;
+	const int SWEEPS = 200000;
+	const float ANGLES[] = {0.001f, 0.01f, 0.1f};
+
+	printf("== terrain\n");
+	Terrain terrain;
+	auto start = std::chrono::steady_clock::now();
+	if (!terrain.load(MARS_MESH_PATH, MARS_BUMP_PATH)) {
+		printf("(run from the repository root)\n");
+		return;
+	}
+	printf("load: %.3f s, texel: %.2e rad\n", seconds_since(start), terrain.get_texel_angle());
+
+	std::mt19937 rng(5);
+	std::normal_distribution<float> normal(0.0f, 1.0f);
+	std::vector<glm::vec3> directions(QUERIES);
+	for (glm::vec3 &d : directions)
+		d = glm::normalize(glm::vec3(normal(rng), normal(rng), normal(rng)));
+
+	float sum = 0.0f; //Keeps the queries
+	start = std::chrono::steady_clock::now();
+	for (const glm::vec3 &d : directions)
+		sum += terrain.get_height(d);
+	printf("%-16s %8.1f ns\n", "point", seconds_since(start) * 1e9 / QUERIES);
+
+	for (float angle : ANGLES) {
+		float min, max, spread = 0.0f;
+		start = std::chrono::steady_clock::now();
+		for (const glm::vec3 &d : directions) {
+			terrain.get_height_range(d, angle, &min, &max);
+			spread += max - min;
+		}
+		char name[32];
+		snprintf(name, sizeof name, "range %.3f rad", angle);
+		printf("%-16s %8.1f ns, mean spread %.3f\n", name, seconds_since(start) * 1e9 / QUERIES, spread / QUERIES);
+		sum += spread;
+	}
+
+	//Steps grazing the surface: a tangent pass at 0 to 0.05 above the sphere, moving 0.5 to 5 per step
+	TerrainSurface surface(&terrain);
+	std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+	std::vector<BodyState> starts(SWEEPS), ends(SWEEPS);
+	for (int i = 0; i < SWEEPS; i++) {
+		glm::vec3 up = directions[i];
+		glm::vec3 side = glm::normalize(glm::cross(up, directions[i + SWEEPS]));
+		glm::vec3 velocity = side * glm::mix(0.5f, 5.0f, uniform(rng));
+		glm::vec3 middle = up * (TerrainSurface::RADIUS + LANDING_ALTITUDE + 0.05f * uniform(rng));
+		starts[i] = {middle - velocity * 0.5f, velocity};
+		ends[i] = {middle + velocity * 0.5f, velocity};
+	}
+
+	int sphere_hits = 0, terrain_hits = 0;
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < SWEEPS; i++)
+		if (get_time_of_impact(starts[i], ends[i], 1.0f, TerrainSurface::RADIUS + LANDING_ALTITUDE) >= 0.0f)
+			sphere_hits++;
+	double sphere = seconds_since(start);
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < SWEEPS; i++)
+		if (get_time_of_impact(starts[i], ends[i], 1.0f, &surface, LANDING_ALTITUDE) >= 0.0f)
+			terrain_hits++;
+	double relief = seconds_since(start);
+	printf("%-16s %8.1f ns, hits %d/%d\n", "sweep sphere", sphere * 1e9 / SWEEPS, sphere_hits, SWEEPS);
+	printf("%-16s %8.1f ns, hits %d/%d\n", "sweep terrain", relief * 1e9 / SWEEPS, terrain_hits, SWEEPS);
+
+	if (sum < 0.0f)
+		printf("%f\n", sum);
+}
+
+struct Benchmark {
+	const char *name;
+	void (*run)();
+};
+
+static const Benchmark BENCHMARKS[] = {
+	{"drift", bench_drift},
+	{"gravity", bench_gravity},
+	{"octree", bench_octree},
+	{"jobs", bench_jobs},
+	{"kepler", bench_kepler},
+	{"terrain", bench_terrain},
+	{"soi", bench_soi},
+};
+
+int main(int argc, char *argv[]) {
+	for (const Benchmark &benchmark : BENCHMARKS) {
+		bool selected = (argc <= 1);
+		for (int i = 1; i < argc; i++)
+			if (std::strcmp(argv[i], benchmark.name) == 0)
+				selected = true;
+
+		if (selected)
+			benchmark.run();
+	}
+
+	return 0;
+}
@@ -0,0 +1,392 @@
+#include "chunked_terrain.hpp"
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <learnopengl/gl_state.h>
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include "frame.hpp"
+#include "utils.hpp"
+
+const int CHUNK_QUADS = 32; //A side
+const int GRID_VERTICES = (CHUNK_QUADS + 1) * (CHUNK_QUADS + 1);
+const int SKIRT_VERTICES = 4 * (CHUNK_QUADS + 1);
+const int VERTEX_FLOATS = 7; //Position (relative to the center), normal, height
+
+const float SPLIT_PIXELS = 1.0f; //Of error on screen
+const float MERGE_PIXELS = 0.5f; //Below the split, so a chunk at the threshold doesn't flicker
+const int CHUNK_BUDGET = 48; //Drawn a frame; about 110k triangles
+const int EXTRA_LEVELS = 3; //Past the terrain's texels; the surface is bilinear there, the sphere still curves
+const int QUEUE_GRAIN = 64; //Chunks queued per job
+const int KEEP_FRAMES = 120; //Before an unused subtree is freed; turning back soon doesn't rebuild it
+
+ChunkedTerrain::ChunkedTerrain(Terrain *terrain, float relief, JobSystem *jobs)
+	: terrain(terrain), relief(relief), jobs(jobs), frame(0), culler(nullptr)
+{
+	//Down to a vertex per texel, and a few more
+	max_level = 0;
+	while ((PI / 2) / (CHUNK_QUADS << max_level) > terrain->get_texel_angle())
+		max_level++;
+	max_level += EXTRA_LEVELS;
+
+	//Grid, then the 4 skirts; the same for every chunk
+	std::vector<unsigned short> indices;
+	const int N = CHUNK_QUADS;
+	for (int j = 0; j < N; j++)
+		for (int i = 0; i < N; i++) {
+			unsigned short a = j * (N + 1) + i, b = a + 1, c = a + (N + 1), d = c + 1;
+			unsigned short quad[6] = {a, c, b, b, c, d};
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	for (int edge = 0; edge < 4; edge++) {
+		unsigned short base = GRID_VERTICES + edge * (N + 1);
+		for (int t = 0; t < N; t++) {
+			//Bottom, top, left, right
+			int e0 = (edge == 0) ? t : (edge == 1) ? N * (N + 1) + t : (edge == 2) ? t * (N + 1) : t * (N + 1) + N;
+			int e1 = (edge == 0 || edge == 1) ? e0 + 1 : e0 + (N + 1);
+			unsigned short quad[6] = {
+				(unsigned short) e0, (unsigned short) (base + t), (unsigned short) e1,
+				(unsigned short) e1, (unsigned short) (base + t), (unsigned short) (base + t + 1)
+			};
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+	index_count = (int) indices.size();
+
+	glGenBuffers(1, &EBO);
+	GLState::bindVertexArray(0); //Or the EBO would go to whichever VAO is bound
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof (unsigned short), indices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	shader = new Shader("shaders/terrain.vs", "shaders/terrain.fs");
+	FrameUniforms::bind(shader);
+	model_uniform = shader->getUniform<glm::mat4>("model");
+
+	//The roots are always there
+	for (int f = 0; f < 6; f++)
+		roots[f] = new_chunk(f, 0, 0, 0);
+	jobs->parallel_for(6, 1, [&](int begin, int end) {
+		for (int f = begin; f < end; f++)
+			build(roots[f]);
+	});
+	for (int f = 0; f < 6; f++) {
+		upload(roots[f]);
+		roots[f]->state = CHUNK_READY;
+	}
+}
+
+ChunkedTerrain::Chunk *ChunkedTerrain::new_chunk(int face, int level, int x, int y) {
+	Chunk *chunk = new Chunk();
+	chunk->face = face;
+	chunk->level = level;
+	chunk->x = x;
+	chunk->y = y;
+
+	float span = 2.0f / (1 << level);
+	float u0 = -1 + x * span, v0 = -1 + y * span;
+	chunk->center = glm::normalize(get_cube_point(face, u0 + span / 2, v0 + span / 2));
+
+	//The corners are the farthest on the sphere; the relief goes either way
+	chunk->bound = 0.0f;
+	for (int c = 0; c < 4; c++) {
+		glm::vec3 corner = glm::normalize(get_cube_point(face, u0 + (c & 1) * span, v0 + (c >> 1) * span));
+		chunk->bound = std::max(chunk->bound, glm::length(corner - chunk->center));
+	}
+	chunk->bound += relief;
+
+	chunk->error = 0.0f;
+	chunk->last_used = frame;
+	chunk->pixels = 0.0f;
+	chunk->state = CHUNK_EMPTY;
+	chunk->VAO = chunk->VBO = 0;
+	for (Chunk *&child : chunk->children)
+		child = nullptr;
+	return chunk;
+}
+
+void ChunkedTerrain::delete_children(Chunk *chunk) {
+	for (Chunk *&child : chunk->children) {
+		if (child == nullptr)
+			continue;
+		delete_children(child);
+		if (child->VAO != 0) {
+			GLState::deleteVertexArray(child->VAO);
+			glDeleteBuffers(1, &child->VBO);
+		}
+		delete child;
+		child = nullptr;
+	}
+}
+
+bool ChunkedTerrain::is_busy(Chunk *chunk) {
+	if (chunk->state == CHUNK_BUILDING || chunk->state == CHUNK_BUILT)
+		return true;
+	for (Chunk *child : chunk->children)
+		if (child != nullptr && is_busy(child))
+			return true;
+	return false;
+}
+
+void ChunkedTerrain::release(Chunk *chunk) {
+	if (chunk->children[0] == nullptr)
+		return;
+
+	bool used = false;
+	for (Chunk *child : chunk->children)
+		used = used || frame - child->last_used <= KEEP_FRAMES;
+
+	if (!used && !is_busy(chunk)) {
+		delete_children(chunk);
+		return;
+	}
+	for (Chunk *child : chunk->children)
+		release(child);
+}
+
+void ChunkedTerrain::build(Chunk *chunk) {
+	const int N = CHUNK_QUADS;
+	const int SIDE = N + 3; //A ring of border vertices for the normals
+	float span = 2.0f / (1 << chunk->level);
+	float u0 = -1 + chunk->x * span, v0 = -1 + chunk->y * span;
+	float step = span / N;
+
+	auto get_surface = [&](float u, float v, float *height) {
+		glm::vec3 direction = glm::normalize(get_cube_point(chunk->face, u, v));
+		*height = terrain->get_height(direction);
+		return direction * (1.0f + relief * (*height - 0.5f));
+	};
+
+	//Grid with its border, [j + 1][i + 1] for i, j in [-1, N + 1]
+	std::vector<glm::vec3> points(SIDE * SIDE);
+	std::vector<float> heights(SIDE * SIDE);
+	for (int j = -1; j <= N + 1; j++)
+		for (int i = -1; i <= N + 1; i++) {
+			int k = (j + 1) * SIDE + (i + 1);
+			points[k] = get_surface(u0 + i * step, v0 + j * step, &heights[k]);
+		}
+	auto at = [&](int i, int j) {return (j + 1) * SIDE + (i + 1);};
+
+	//Largest gap between the mesh and the surface, at the middle of the quads and of their edges
+	float error = 0.0f;
+	float height;
+	for (int j = 0; j < N; j++)
+		for (int i = 0; i < N; i++) {
+			glm::vec3 a = points[at(i, j)], b = points[at(i + 1, j)], c = points[at(i, j + 1)], d = points[at(i + 1, j + 1)];
+			float u = u0 + i * step, v = v0 + j * step;
+			error = std::max(error, glm::length(get_surface(u + step / 2, v + step / 2, &height) - (a + b + c + d) / 4.0f));
+			error = std::max(error, glm::length(get_surface(u + step / 2, v, &height) - (a + b) / 2.0f));
+			error = std::max(error, glm::length(get_surface(u, v + step / 2, &height) - (a + c) / 2.0f));
+		}
+	chunk->error = error;
+
+	//The skirts drop below anything a coarser neighbour may leave open
+	float skirt = std::max(4 * error, step);
+
+	std::vector<float> &vertices = chunk->vertices;
+	vertices.clear();
+	vertices.reserve((GRID_VERTICES + SKIRT_VERTICES) * VERTEX_FLOATS);
+	auto add_vertex = [&](int i, int j, float drop) {
+		glm::vec3 p = points[at(i, j)];
+		glm::vec3 normal = glm::normalize(glm::cross(points[at(i + 1, j)] - points[at(i - 1, j)], points[at(i, j + 1)] - points[at(i, j - 1)]));
+		if (glm::dot(normal, p) < 0)
+			normal = -normal;
+		glm::vec3 position = p * (1.0f - drop) - chunk->center;
+		float v[VERTEX_FLOATS] = {position.x, position.y, position.z, normal.x, normal.y, normal.z, heights[at(i, j)]};
+		vertices.insert(vertices.end(), v, v + VERTEX_FLOATS);
+	};
+	for (int j = 0; j <= N; j++)
+		for (int i = 0; i <= N; i++)
+			add_vertex(i, j, 0.0f);
+	//Bottom, top, left, right, as the indices
+	for (int t = 0; t <= N; t++) add_vertex(t, 0, skirt);
+	for (int t = 0; t <= N; t++) add_vertex(t, N, skirt);
+	for (int t = 0; t <= N; t++) add_vertex(0, t, skirt);
+	for (int t = 0; t <= N; t++) add_vertex(N, t, skirt);
+}
+
+void ChunkedTerrain::upload(Chunk *chunk) {
+	glGenVertexArrays(1, &chunk->VAO);
+	GLState::bindVertexArray(chunk->VAO);
+
+	glGenBuffers(1, &chunk->VBO);
+	glBindBuffer(GL_ARRAY_BUFFER, chunk->VBO);
+	glBufferData(GL_ARRAY_BUFFER, chunk->vertices.size() * sizeof (float), chunk->vertices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof (float), (void *) 0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof (float), (void *) (3 * sizeof (float)));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, VERTEX_FLOATS * sizeof (float), (void *) (6 * sizeof (float)));
+	glEnableVertexAttribArray(2);
+
+	//Unbind; the EBO stays with the VAO
+	GLState::bindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	std::vector<float>().swap(chunk->vertices);
+}
+
+void ChunkedTerrain::select(glm::vec3 camera, float pixels_per_radian) {
+	auto by_pixels = [](const Chunk *a, const Chunk *b) {return a->pixels < b->pixels;};
+	auto add_candidate = [&](Chunk *chunk) {
+		if (!is_visible(chunk))
+			return false; //Its children are kept for a while, in case it comes back
+		chunk->last_used = frame;
+
+		float dist = std::max(glm::length(camera - chunk->center) - chunk->bound, 1e-6f);
+		chunk->pixels = chunk->error / dist * pixels_per_radian;
+		candidates.push_back(chunk);
+		std::push_heap(candidates.begin(), candidates.end(), by_pixels);
+		return true;
+	};
+
+	candidates.clear();
+	int count = 0; //Of the cut: candidates and selected
+	for (Chunk *root : roots)
+		count += add_candidate(root);
+
+	//Split the worst chunk until none is worth it, or the budget is spent
+	while (!candidates.empty()) {
+		std::pop_heap(candidates.begin(), candidates.end(), by_pixels);
+		Chunk *chunk = candidates.back();
+		candidates.pop_back();
+
+		bool ready = chunk->children[0] != nullptr;
+		for (Chunk *child : chunk->children)
+			ready = ready && child->state == CHUNK_READY;
+
+		float threshold = ready ? MERGE_PIXELS : SPLIT_PIXELS;
+		if (chunk->pixels <= threshold || chunk->level >= max_level || count + 3 > CHUNK_BUDGET) {
+			visible.push_back(chunk);
+			continue;
+		}
+
+		if (!ready) {
+			if (chunk->children[0] == nullptr) {
+				for (int c = 0; c < 4; c++)
+					chunk->children[c] = new_chunk(chunk->face, chunk->level + 1, 2 * chunk->x + (c & 1), 2 * chunk->y + (c >> 1));
+			}
+			//Wanted: kept, with the siblings already built, however long the queue
+			for (Chunk *child : chunk->children) {
+				child->last_used = frame;
+				if (child->state == CHUNK_EMPTY)
+					pending.push_back(child);
+			}
+			visible.push_back(chunk);
+			continue;
+		}
+
+		count--;
+		for (Chunk *child : chunk->children)
+			count += add_candidate(child);
+	}
+}
+
+bool ChunkedTerrain::is_visible(Chunk *chunk) {
+	//The lowest the relief goes hides what is behind it
+	glm::vec3 center = frame_offset + frame_rotation * chunk->center * frame_radius;
+	float occluder_radius = frame_radius * (1.0f - 0.5f * relief);
+	return culler->is_visible(CULL_CHUNKS, center, chunk->bound * frame_radius, frame_offset, occluder_radius);
+}
+
+void ChunkedTerrain::draw(glm::dvec3 offset, glm::mat3 rotation, float radius, float pixels_per_radian, Culler *culler, RenderQueue *queue) {
+	//The camera in the planet's frame and units
+	glm::vec3 camera = glm::transpose(rotation) * glm::vec3(-offset / (double) radius);
+	frame_offset = glm::vec3(offset);
+	frame_rotation = rotation;
+	frame_radius = radius;
+	this->culler = culler;
+	frame++;
+
+	//What the workers finished since the last frame
+	for (size_t i = 0; i < building.size();) {
+		Chunk *chunk = building[i];
+		if (chunk->state == CHUNK_BUILT) {
+			upload(chunk);
+			chunk->state = CHUNK_READY;
+			building[i] = building.back();
+			building.pop_back();
+		}
+		else {
+			i++;
+		}
+	}
+
+	visible.clear();
+	pending.clear();
+	select(camera, pixels_per_radian);
+	for (Chunk *root : roots)
+		release(root);
+
+	//A few builds at a time, coarsest first: they unblock the most
+	std::stable_sort(pending.begin(), pending.end(), [](const Chunk *a, const Chunk *b) {return a->level < b->level;});
+	int count = std::min((int) pending.size(), 2 * jobs->get_thread_count() - (int) building.size());
+	for (int i = 0; i < count; i++) {
+		Chunk *chunk = pending[i];
+		chunk->state = CHUNK_BUILDING;
+		building.push_back(chunk);
+		jobs->run_async([this, chunk] {
+			build(chunk);
+			chunk->state = CHUNK_BUILT;
+		});
+	}
+
+	//Each chunk is placed in double, relative to the camera, so its vertices stay small
+	glm::mat4 orientation = glm::scale(glm::mat4(rotation), glm::vec3(radius));
+	jobs->parallel_for((int) visible.size(), QUEUE_GRAIN, [&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			Chunk *chunk = visible[i];
+			glm::dvec3 chunk_offset = offset + glm::dvec3(rotation * chunk->center) * (double) radius;
+
+			DrawItem item;
+			item.key = RenderQueue::make_key(PASS_OPAQUE, shader->ID, 0, (float) glm::length(chunk_offset), chunk->VAO);
+			item.draw = draw_chunk;
+			item.owner = this;
+			item.data = chunk;
+			item.model = glm::translate(glm::mat4(1.0f), glm::vec3(chunk_offset)) * orientation;
+			item.count = index_count;
+			queue->add(item);
+		}
+	});
+}
+
+void ChunkedTerrain::draw_chunk(const DrawItem &item) {
+	ChunkedTerrain *terrain = (ChunkedTerrain *) item.owner;
+	Chunk *chunk = (Chunk *) item.data;
+
+	terrain->shader->use();
+	terrain->shader->set(terrain->model_uniform, item.model);
+	GLState::bindVertexArray(chunk->VAO);
+	glDrawElements(GL_TRIANGLES, item.count, GL_UNSIGNED_SHORT, (void *) 0);
+}
+
+int ChunkedTerrain::get_chunk_count() {
+	return (int) visible.size();
+}
+
+int ChunkedTerrain::get_triangle_count() {
+	return (int) visible.size() * index_count / 3;
+}
+
+ChunkedTerrain::~ChunkedTerrain() {
+	//The workers still hold the chunks being built
+	for (Chunk *chunk : building)
+		while (chunk->state == CHUNK_BUILDING)
+			std::this_thread::yield();
+
+	for (Chunk *root : roots) {
+		delete_children(root);
+		GLState::deleteVertexArray(root->VAO);
+		glDeleteBuffers(1, &root->VBO);
+		delete root;
+	}
+	glDeleteBuffers(1, &EBO);
+	delete shader;
+}
@@ -0,0 +1,91 @@
+#ifndef CHUNKED_TERRAIN_HPP
+#define CHUNKED_TERRAIN_HPP
+
+#include <glm/glm.hpp>
+#include <learnopengl/shader_m.h>
+
+#include <atomic>
+#include <vector>
+
+#include "culling.hpp"
+#include "jobs.hpp"
+#include "render_queue.hpp"
+#include "terrain.hpp"
+
+/*
+Level-of-detail mesh of a `Terrain`: each face of the cube-sphere is a quadtree of chunks, all with the same grid,
+so a chunk at level k covers 1/4^k of its face at 4^k times the detail.
+A chunk splits when its error (the largest gap between its mesh and the surface) covers more than a pixel on screen,
+the worst first, until the budget of chunks is spent: about as many triangles are drawn from orbit as at touchdown.
+Chunks are built on the job system's threads, a few at a time, without waiting on them: a built chunk is uploaded
+by the next `draw()`, and a chunk is drawn until all 4 of its children are ready.
+The chunks' draws are queued on the same threads, front to back.
+Skirts hang from the chunks' edges to hide the cracks between levels.
+Chunks out of the frustum, or behind the planet's limb as seen from the camera, are neither drawn nor split;
+the subtrees left out for a few seconds, culled or merged, are freed.
+Units are planet radii, in the planet's own (unrotated) frame.
+*/
+class ChunkedTerrain {
+public:
+	ChunkedTerrain(Terrain *terrain, float relief, JobSystem *jobs); //Needs the GL context; builds the 6 roots. Not owned.
+	~ChunkedTerrain();
+
+	//Queues the draws of the chunks for the camera. `offset`: center of the planet relative to the camera; `rotation`: planet frame to world
+	void draw(glm::dvec3 offset, glm::mat3 rotation, float radius, float pixels_per_radian, Culler *culler, RenderQueue *queue);
+
+	int get_chunk_count(); //Drawn by the last `draw()`
+	int get_triangle_count();
+
+private:
+	enum ChunkState {CHUNK_EMPTY, CHUNK_BUILDING, CHUNK_BUILT, CHUNK_READY};
+
+	struct Chunk {
+		int face, level, x, y; //Tile (x, y) of the 2^level x 2^level grid on `face`
+		glm::vec3 center; //On the sphere
+		float bound; //Radius of a sphere around `center` holding the chunk
+		float error; //Of the mesh, once built
+		int last_used; //Last frame it was visible, or wanted by a split
+		float pixels; //Its error on screen, in the current `draw()`
+
+		std::atomic<int> state; //ChunkState; a worker only sets CHUNK_BUILT
+		std::vector<float> vertices; //Built by a worker, until uploaded
+		unsigned int VAO, VBO; //0 until uploaded
+
+		Chunk *children[4]; //nullptr if not split
+	};
+
+	Chunk *new_chunk(int face, int level, int x, int y);
+	void delete_children(Chunk *chunk);
+	bool is_busy(Chunk *chunk); //Some of it is building, or built and not uploaded
+	void release(Chunk *chunk); //Frees the subtrees under it left unused for a while
+	void build(Chunk *chunk); //Thread-safe
+	void upload(Chunk *chunk);
+	void select(glm::vec3 camera, float pixels_per_radian); //Fills `visible` and `pending`
+	bool is_visible(Chunk *chunk); //Against `culler`, in the frame of the current `draw()`
+	static void draw_chunk(const DrawItem &item);
+
+	Terrain *terrain;
+	float relief;
+	JobSystem *jobs;
+	int max_level;
+	int frame; //Counts the `draw()`s
+
+	Chunk *roots[6];
+	std::vector<Chunk *> visible; //Of the last `draw()`
+	std::vector<Chunk *> pending; //Wanted by the last `draw()`, not built yet
+	std::vector<Chunk *> building; //Started, not uploaded yet
+	std::vector<Chunk *> candidates; //Heap on `pixels`, while selecting
+
+	//Of the current `draw()`
+	glm::vec3 frame_offset;
+	glm::mat3 frame_rotation;
+	float frame_radius;
+	Culler *culler;
+
+	unsigned int EBO; //Shared by every chunk
+	int index_count;
+	Shader *shader;
+	Uniform<glm::mat4> model_uniform;
+};
+
+#endif
@@ -0,0 +1,60 @@
+#include "culling.hpp"
+
+#include <cmath>
+
+Culler::Culler() {
+	begin_frame(glm::mat4(1.0f));
+}
+
+void Culler::begin_frame(const glm::mat4 &projection_view) {
+	frustum = createFrustumFromMatrix(projection_view);
+	for (int g = 0; g < CULL_GROUP_COUNT; g++)
+		visible[g] = total[g] = 0;
+}
+
+bool Culler::is_visible(CullGroup group, glm::vec3 center, float radius) {
+	total[group]++;
+	if (!is_in_frustum(center, radius))
+		return false;
+	visible[group]++;
+	return true;
+}
+
+bool Culler::is_visible(CullGroup group, glm::vec3 center, float radius, glm::vec3 occluder_center, float occluder_radius) {
+	total[group]++;
+	if (!is_in_frustum(center, radius) || is_beyond_horizon(center, radius, occluder_center, occluder_radius))
+		return false;
+	visible[group]++;
+	return true;
+}
+
+int Culler::get_visible(CullGroup group) {
+	return visible[group];
+}
+
+int Culler::get_total(CullGroup group) {
+	return total[group];
+}
+
+bool Culler::is_in_frustum(glm::vec3 center, float radius) {
+	return Sphere(center, radius).isOnFrustum(frustum);
+}
+
+bool Culler::is_beyond_horizon(glm::vec3 center, float radius, glm::vec3 occluder_center, float occluder_radius) {
+	//The camera (at the origin) sees the occluder's limb as a circle, the base of a cone along `axis`.
+	//Inside that cone and past the circle's plane is the occluder or its far side.
+	float d = glm::length(occluder_center);
+	float c = glm::length(center);
+	if (d <= occluder_radius || c <= radius)
+		return false; //Inside one of them
+	glm::vec3 axis = occluder_center / d;
+
+	float along = glm::dot(center, axis);
+	float limb = (d * d - occluder_radius * occluder_radius) / d; //Distance of the circle's plane
+	if (along - radius < limb)
+		return false;
+
+	float cone = std::asin(occluder_radius / d);
+	float angle = std::acos(glm::clamp(along / c, -1.0f, 1.0f));
+	return angle + std::asin(radius / c) < cone;
+}
@@ -0,0 +1,42 @@
+#ifndef CULLING_HPP
+#define CULLING_HPP
+
+#include <glm/glm.hpp>
+#include <learnopengl/frustum.h>
+
+//What is culled, each with its counters
+enum CullGroup {
+	CULL_PLANETS,
+	CULL_CHUNKS, //Of the terrain
+	CULL_SHAPES, //Lines, rings, cubes and orbits of the debug shapes
+	CULL_GROUP_COUNT
+};
+
+/*
+Culling stage of a frame, before any GL call: bounding spheres are tested against the frustum of `projection * view`,
+and optionally against the horizon of a sphere in front of them (the planet hiding its far side).
+Coordinates are relative to the camera, as everything is drawn.
+*/
+class Culler {
+public:
+	Culler();
+
+	void begin_frame(const glm::mat4 &projection_view); //Extracts the frustum; clears the counters
+
+	bool is_visible(CullGroup group, glm::vec3 center, float radius); //Counted
+	//Also false if hidden behind the limb of the sphere (`occluder_center`, `occluder_radius`)
+	bool is_visible(CullGroup group, glm::vec3 center, float radius, glm::vec3 occluder_center, float occluder_radius);
+
+	int get_visible(CullGroup group); //Since `begin_frame()`
+	int get_total(CullGroup group);
+
+private:
+	bool is_in_frustum(glm::vec3 center, float radius);
+	static bool is_beyond_horizon(glm::vec3 center, float radius, glm::vec3 occluder_center, float occluder_radius);
+
+	Frustum frustum;
+	int visible[CULL_GROUP_COUNT];
+	int total[CULL_GROUP_COUNT];
+};
+
+#endif
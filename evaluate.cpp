@@ -0,0 +1,241 @@
+#include "evaluate.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define EVALUATE_MXCSR
+#endif
+
+#include "jobs.hpp"
+#include "kepler.hpp"
+#include "landing.hpp"
+#include "terrain.hpp"
+#include "planet.hpp"
+#include "player.hpp"
+#include "simulation.hpp"
+#include "utils.hpp"
+
+const float FRAME_TIME = 1.0f / 60;
+const float MAX_TIME = 1200.0f; //Simulated; a run that takes longer is a miss
+const float ESCAPE_DISTANCE = 100.0f; //Too far to fall back
+const float MAX_WARP = 100000.0f;
+const float TURN_RATE = 1.0f; //Radians per second, as the keys
+const float ALIGNMENT = 0.985f; //cos(10 degrees); burns only when pointing within that
+
+/*
+Autopilot: coasts, warping while the planet is far, then below `burn_altitude`
+turns retrograde and burns at `throttle` until the speed is under `target_speed`.
+*/
+struct Pilot {
+	float burn_altitude;
+	float throttle; //Of the full thrust of the keys
+	float target_speed;
+};
+
+struct Run {
+	Pilot pilot;
+	bool landed;
+	LandingScore score;
+	double time; //Simulated
+	long long ticks;
+};
+
+static float wrap_angle(float x) {
+	return std::remainder(x, 2*PI);
+}
+
+static glm::vec3 random_direction(std::mt19937 *rng) {
+	std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+	glm::vec3 p;
+	do {
+		p = glm::vec3(uniform(*rng), uniform(*rng), uniform(*rng));
+	} while (glm::dot(p, p) > 1.0f || glm::dot(p, p) < 1e-4f);
+	return glm::normalize(p);
+}
+
+static void fly(Run *run, unsigned int seed, int index, Terrain *terrain) {
+#ifdef EVALUATE_MXCSR
+	//Flush denormals: braking decays velocity components into them, and each operation on one costs ~100 cycles
+	unsigned int mxcsr = _mm_getcsr();
+	_mm_setcsr(mxcsr | 0x8040); //FTZ | DAZ
+#endif
+
+	std::seed_seq seq {seed, (unsigned int) index};
+	std::mt19937 rng(seq);
+	std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+	//As in `main()`, without drawing
+	Planet planet(nullptr, nullptr, 5.0f, 0.01f, 100.0f, 0.05f, glm::vec3(0.0f, 1.0f, 0.0f));
+	planet.set_terrain(terrain, MARS_RELIEF);
+	glm::dvec3 planet_position, planet_velocity;
+	planet.get_orbit_state(0.0, &planet_position, &planet_velocity);
+
+	//Start 10 to 25 away (it can't hold the ship much further against its own orbit),
+	//moving with the planet plus up to the circular speed sideways and half of it inwards
+	glm::vec3 out = random_direction(&rng);
+	glm::vec3 side = glm::normalize(glm::cross(out, random_direction(&rng)));
+	float dist = glm::mix(10.0f, 25.0f, uniform(rng));
+	float circular_speed = std::sqrt(planet.get_gm() / dist);
+
+	BodyState state;
+	state.position = planet_position + glm::dvec3(out * dist);
+	state.velocity = planet_velocity + glm::dvec3(circular_speed * (side * uniform(rng) - out * (0.5f * uniform(rng))));
+
+	run->pilot.burn_altitude = glm::mix(2.0f, 20.0f, uniform(rng));
+	run->pilot.throttle = glm::mix(0.25f, 1.0f, uniform(rng));
+	run->pilot.target_speed = glm::mix(0.5f, 6.0f, uniform(rng));
+	const Pilot &pilot = run->pilot;
+
+	Player player(state.position, std::asin(-out.y), std::atan2(-out.z, -out.x)); //Facing the planet
+	player.set_state(state);
+	Simulation simulation(&planet, &player);
+
+	run->landed = false;
+	while (simulation.get_time() < MAX_TIME) {
+		state = player.get_state();
+		planet.get_orbit_state(simulation.get_time(), &planet_position, &planet_velocity);
+		glm::vec3 to_planet(planet_position - state.position);
+		float altitude = glm::length(to_planet) - planet.get_surface_radius(-to_planet, simulation.get_time());
+
+		if (simulation.has_contact()) {
+			const Contact &contact = simulation.get_contact();
+			run->landed = true;
+			run->score = score_landing(glm::vec3(contact.state.velocity), glm::vec3(contact.planet_position - contact.state.position));
+			break;
+		}
+		if (altitude > ESCAPE_DISTANCE)
+			break;
+
+		glm::vec3 velocity(state.velocity);
+		float speed = glm::length(velocity);
+		float forward_offset = 0.0f, pitch_offset = 0.0f, yaw_offset = 0.0f;
+		if (altitude < pilot.burn_altitude && speed > pilot.target_speed) {
+			glm::vec3 retrograde = -velocity / speed;
+			float max_turn = TURN_RATE * FRAME_TIME;
+			pitch_offset = glm::clamp(std::asin(retrograde.y) - player.get_pitch(), -max_turn, max_turn);
+			yaw_offset = glm::clamp(wrap_angle(std::atan2(retrograde.z, retrograde.x) - player.get_yaw()), -max_turn, max_turn);
+
+			glm::vec3 front, right, up;
+			player.get_camera_vecs(&front, &right, &up);
+			if (glm::dot(front, retrograde) > ALIGNMENT)
+				forward_offset = pilot.throttle * FRAME_TIME;
+		}
+
+		//Warp while a frame covers under half of the way to what the autopilot reacts to, as a player would:
+		//the burn altitude, then the ground and the speed gravity adds past the target
+		float warp = 1.0f;
+		if (forward_offset == 0.0f) {
+			float approach_speed = (float) glm::length(state.velocity - planet_velocity);
+			bool braking = altitude < pilot.burn_altitude;
+			float way = braking ? altitude : altitude - pilot.burn_altitude;
+			float gravity = planet.get_gm() / glm::dot(to_planet, to_planet);
+			auto fits = [&](float warp) {
+				float frame = FRAME_TIME * warp;
+				return approach_speed * frame < way * 0.5f && (!braking || gravity * frame < (pilot.target_speed - speed) * 0.5f);
+			};
+			while (warp < MAX_WARP && fits(warp * 10))
+				warp *= 10;
+		}
+
+		player.process_input(forward_offset, pitch_offset, yaw_offset);
+		simulation.set_warp(warp);
+		simulation.advance(FRAME_TIME);
+	}
+
+	run->time = simulation.get_time();
+	run->ticks = simulation.get_ticks();
+
+#ifdef EVALUATE_MXCSR
+	_mm_setcsr(mxcsr);
+#endif
+}
+
+static void print_distribution(const char *name, std::vector<float> values) {
+	if (values.empty())
+		return;
+	std::sort(values.begin(), values.end());
+
+	double sum = 0.0;
+	for (float value : values)
+		sum += value;
+	auto percentile = [&](float p) {return values[(size_t) (p * (values.size() - 1))];};
+
+	printf("%-12s %8.2f %8.2f %8.2f %8.2f %8.2f %8.2f\n", name,
+		sum / values.size(), values.front(), percentile(0.1f), percentile(0.5f), percentile(0.9f), values.back());
+}
+
+int run_evaluation(int runs, unsigned int seed, int thread_count) {
+	JobSystem jobs(thread_count);
+	std::vector<Run> results(runs);
+
+	//Loaded once; the runs only read it
+	Terrain terrain;
+	terrain.load(MARS_MESH_PATH, MARS_BUMP_PATH);
+
+	auto start = std::chrono::steady_clock::now();
+	jobs.parallel_for(runs, 1, [&](int begin, int end) {
+		for (int i = begin; i < end; i++)
+			fly(&results[i], seed, i, &terrain);
+	});
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	//Distributions over the landed runs
+	std::vector<float> speeds, speed_scores, angle_scores, totals;
+	double simulated = 0.0;
+	long long ticks = 0;
+	int best = -1;
+	for (int i = 0; i < runs; i++) {
+		const Run &run = results[i];
+		simulated += run.time;
+		ticks += run.ticks;
+		if (!run.landed)
+			continue;
+
+		speeds.push_back(run.score.speed);
+		speed_scores.push_back(run.score.speed_score);
+		angle_scores.push_back(run.score.angle_score);
+		totals.push_back(run.score.total);
+		if (best < 0 || run.score.total > results[best].score.total)
+			best = i;
+	}
+
+	printf("Runs: %d, landed: %d (%.1f%%), seed: %u, threads: %d\n",
+		runs, (int) totals.size(), 100.0 * totals.size() / std::max(runs, 1), seed, jobs.get_thread_count());
+	printf("%-12s %8s %8s %8s %8s %8s %8s\n", "", "mean", "min", "p10", "p50", "p90", "max");
+	print_distribution("speed", speeds);
+	print_distribution("speed score", speed_scores);
+	print_distribution("angle score", angle_scores);
+	print_distribution("total", totals);
+
+	//Histogram of the total score
+	const int BINS = 10;
+	const int BAR = 50;
+	int counts[BINS] = {};
+	for (float total : totals)
+		counts[glm::clamp((int) (total / (100.0f / BINS)), 0, BINS - 1)]++;
+	int most = *std::max_element(counts, counts + BINS);
+	for (int b = 0; b < BINS; b++) {
+		printf("%3d-%3d %7d ", b * 100 / BINS, (b + 1) * 100 / BINS, counts[b]);
+		for (int i = 0; i < (most > 0 ? counts[b] * BAR / most : 0); i++)
+			putchar('#');
+		putchar('\n');
+	}
+
+	if (best >= 0) {
+		const Pilot &pilot = results[best].pilot;
+		printf("Best: %.2f (burn altitude %.2f, throttle %.2f, target speed %.2f)\n",
+			results[best].score.total, pilot.burn_altitude, pilot.throttle, pilot.target_speed);
+	}
+
+	printf("Simulated %.0f s in %.3f s: %.0f simulated s/s, %.0f ticks/s\n",
+		simulated, seconds, simulated / seconds, ticks / seconds);
+	return 0;
+}
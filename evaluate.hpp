@@ -0,0 +1,11 @@
+#ifndef EVALUATE_HPP
+#define EVALUATE_HPP
+
+/*
+Headless Monte-Carlo evaluation of the landing.
+Flies `runs` landings from random starts, each with an autopilot of random parameters, over all the cores,
+and prints the distributions of the scores. The results only depend on `seed`, not on the thread count.
+*/
+int run_evaluation(int runs, unsigned int seed, int thread_count=0);
+
+#endif
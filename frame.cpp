@@ -0,0 +1,47 @@
+#include "frame.hpp"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+
+//Offsets of the std140 layout
+static_assert(sizeof (CameraBlock) == 144, "std140 Camera");
+static_assert(offsetof(CameraBlock, view_pos) == 128, "std140 Camera");
+static_assert(sizeof (DirLightBlock) == 64, "std140 DirLight");
+static_assert(offsetof(SpotLightBlock, cut_off) == 28, "std140 SpotLight");
+static_assert(offsetof(SpotLightBlock, ambient) == 48, "std140 SpotLight");
+static_assert(sizeof (SpotLightBlock) == 96, "std140 SpotLight");
+static_assert(offsetof(LightsBlock, spot_light) == 64, "std140 Lights");
+
+FrameUniforms::FrameUniforms() {
+	int alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	lights_offset = ((int) sizeof (CameraBlock) + alignment - 1) / alignment * alignment;
+	size = lights_offset + (int) sizeof (LightsBlock);
+
+	glGenBuffers(1, &UBO);
+	glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+	glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void FrameUniforms::update(const CameraBlock &camera, const LightsBlock &lights) {
+	//Orphan the old storage so the upload doesn't wait for the last frame's draws
+	glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+	glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof (CameraBlock), &camera);
+	glBufferSubData(GL_UNIFORM_BUFFER, lights_offset, sizeof (LightsBlock), &lights);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	glBindBufferRange(GL_UNIFORM_BUFFER, CAMERA_BINDING, UBO, 0, sizeof (CameraBlock));
+	glBindBufferRange(GL_UNIFORM_BUFFER, LIGHTS_BINDING, UBO, lights_offset, sizeof (LightsBlock));
+}
+
+void FrameUniforms::bind(Shader *shader) {
+	shader->bindBlock("Camera", CAMERA_BINDING);
+	shader->bindBlock("Lights", LIGHTS_BINDING);
+}
+
+FrameUniforms::~FrameUniforms() {
+	glDeleteBuffers(1, &UBO);
+}
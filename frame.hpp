@@ -0,0 +1,66 @@
+#ifndef FRAME_HPP
+#define FRAME_HPP
+
+#include <glm/glm.hpp>
+#include <learnopengl/shader_m.h>
+
+//Binding points of the per-frame uniform blocks, the same for every shader
+const unsigned int CAMERA_BINDING = 0;
+const unsigned int LIGHTS_BINDING = 1;
+
+//std140 mirrors of the blocks in the shaders: vec3s take 16 bytes, so they're padded by hand
+
+//`uniform Camera`
+struct CameraBlock {
+	glm::mat4 projection;
+	glm::mat4 view;
+	glm::vec3 view_pos; float pad0;
+};
+
+//`struct DirLight`
+struct DirLightBlock {
+	glm::vec3 direction; float pad0;
+	glm::vec3 ambient; float pad1;
+	glm::vec3 diffuse; float pad2;
+	glm::vec3 specular; float pad3;
+};
+
+//`struct SpotLight`
+struct SpotLightBlock {
+	glm::vec3 position; float pad0;
+	glm::vec3 direction; float cut_off;
+	float outer_cut_off;
+	float constant;
+	float linear;
+	float quadratic;
+	glm::vec3 ambient; float pad1;
+	glm::vec3 diffuse; float pad2;
+	glm::vec3 specular; float pad3;
+};
+
+//`uniform Lights`
+struct LightsBlock {
+	DirLightBlock dir_light;
+	SpotLightBlock spot_light;
+};
+
+/*
+Data shared by every draw of a frame, in one uniform buffer written once per frame:
+the camera for the vertex shaders, the lights for the lit fragment shaders. Draws then only set their model.
+*/
+class FrameUniforms {
+public:
+	FrameUniforms(); //Needs the GL context
+	~FrameUniforms();
+
+	void update(const CameraBlock &camera, const LightsBlock &lights); //One upload; binds both blocks
+
+	static void bind(Shader *shader); //Points the shader's blocks to their bindings. Once per shader, after linking.
+
+private:
+	unsigned int UBO;
+	int lights_offset; //Aligned to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	int size;
+};
+
+#endif
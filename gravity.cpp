@@ -0,0 +1,320 @@
+#include "gravity.hpp"
+#include "octree.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define GRAVITY_AVX2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define GRAVITY_NEON
+#endif
+
+const int BODY_GRAIN = 64; //Bodies per job
+const int PARTICLE_GRAIN = 4096; //Test particles per job
+
+/*
+Kernels: the pull of the bodies [0, n) on (px, py, pz), as
+	sum gm_j * d_j / (|d_j|^2 + eps^2)^(3/2)
+Bodies at the exact position of the target (itself) are skipped.
+*/
+
+static glm::vec3 accumulate_scalar(
+	const float *x, const float *y, const float *z, const float *gm, int n,
+	float px, float py, float pz, float softening2
+) {
+	float sx = 0.0f, sy = 0.0f, sz = 0.0f;
+	for (int j = 0; j < n; j++) {
+		float dx = x[j] - px, dy = y[j] - py, dz = z[j] - pz;
+		float r2 = dx*dx + dy*dy + dz*dz + softening2;
+		if (r2 <= 0.0f)
+			continue;
+
+		float inv = 1.0f / std::sqrt(r2);
+		float s = gm[j] * inv * inv * inv;
+		sx += dx * s;
+		sy += dy * s;
+		sz += dz * s;
+	}
+	return glm::vec3(sx, sy, sz);
+}
+
+#ifdef GRAVITY_AVX2
+static inline float hsum_avx2(__m256 v) {
+	__m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+	s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+	s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+	return _mm_cvtss_f32(s);
+}
+
+static glm::vec3 accumulate_avx2(
+	const float *x, const float *y, const float *z, const float *gm, int n,
+	float px, float py, float pz, float softening2
+) {
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 three_halves = _mm256_set1_ps(1.5f);
+	const __m256 eps2 = _mm256_set1_ps(softening2);
+	__m256 vpx = _mm256_set1_ps(px), vpy = _mm256_set1_ps(py), vpz = _mm256_set1_ps(pz);
+	__m256 sx = zero, sy = zero, sz = zero;
+
+	for (int j = 0; j < n; j += 8) {
+		__m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x + j), vpx);
+		__m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y + j), vpy);
+		__m256 dz = _mm256_sub_ps(_mm256_loadu_ps(z + j), vpz);
+		__m256 r2 = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_fmadd_ps(dz, dz, eps2)));
+
+		//12-bit estimate + one Newton step
+		__m256 inv = _mm256_rsqrt_ps(r2);
+		inv = _mm256_mul_ps(inv, _mm256_fnmadd_ps(_mm256_mul_ps(half, r2), _mm256_mul_ps(inv, inv), three_halves));
+		inv = _mm256_and_ps(inv, _mm256_cmp_ps(r2, zero, _CMP_GT_OQ));
+
+		__m256 s = _mm256_mul_ps(_mm256_loadu_ps(gm + j), _mm256_mul_ps(inv, _mm256_mul_ps(inv, inv)));
+		sx = _mm256_fmadd_ps(dx, s, sx);
+		sy = _mm256_fmadd_ps(dy, s, sy);
+		sz = _mm256_fmadd_ps(dz, s, sz);
+	}
+	return glm::vec3(hsum_avx2(sx), hsum_avx2(sy), hsum_avx2(sz));
+}
+#endif
+
+#ifdef GRAVITY_NEON
+static glm::vec3 accumulate_neon(
+	const float *x, const float *y, const float *z, const float *gm, int n,
+	float px, float py, float pz, float softening2
+) {
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+	const float32x4_t eps2 = vdupq_n_f32(softening2);
+	float32x4_t vpx = vdupq_n_f32(px), vpy = vdupq_n_f32(py), vpz = vdupq_n_f32(pz);
+	float32x4_t sx = zero, sy = zero, sz = zero;
+
+	for (int j = 0; j < n; j += 4) {
+		float32x4_t dx = vsubq_f32(vld1q_f32(x + j), vpx);
+		float32x4_t dy = vsubq_f32(vld1q_f32(y + j), vpy);
+		float32x4_t dz = vsubq_f32(vld1q_f32(z + j), vpz);
+		float32x4_t r2 = vfmaq_f32(vfmaq_f32(vfmaq_f32(eps2, dz, dz), dy, dy), dx, dx);
+
+		//8-bit estimate + two Newton steps
+		float32x4_t inv = vrsqrteq_f32(r2);
+		inv = vmulq_f32(inv, vrsqrtsq_f32(vmulq_f32(r2, inv), inv));
+		inv = vmulq_f32(inv, vrsqrtsq_f32(vmulq_f32(r2, inv), inv));
+		inv = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(inv), vcgtq_f32(r2, zero)));
+
+		float32x4_t s = vmulq_f32(vld1q_f32(gm + j), vmulq_f32(inv, vmulq_f32(inv, inv)));
+		sx = vfmaq_f32(sx, dx, s);
+		sy = vfmaq_f32(sy, dy, s);
+		sz = vfmaq_f32(sz, dz, s);
+	}
+	return glm::vec3(vaddvq_f32(sx), vaddvq_f32(sy), vaddvq_f32(sz));
+}
+#endif
+
+glm::vec3 accumulate_gravity(
+	GravityKernel kernel,
+	const float *x, const float *y, const float *z, const float *gm, int n,
+	glm::vec3 target, float softening2
+) {
+	if (kernel == GravityKernel::SIMD) {
+#if defined(GRAVITY_AVX2)
+		return accumulate_avx2(x, y, z, gm, n, target.x, target.y, target.z, softening2);
+#elif defined(GRAVITY_NEON)
+		return accumulate_neon(x, y, z, gm, n, target.x, target.y, target.z, softening2);
+#endif
+	}
+	return accumulate_scalar(x, y, z, gm, n, target.x, target.y, target.z, softening2);
+}
+
+GravityEngine::GravityEngine(float softening) : softening2(softening * softening) {
+	count = 0;
+	kernel = GravityKernel::SIMD;
+	mode = GravityMode::DIRECT;
+	theta = 0.5f;
+	accelerations_valid = false;
+
+	jobs = nullptr;
+	tree = new Octree();
+	tree_valid = false;
+}
+
+GravityEngine::~GravityEngine() {
+	delete tree;
+}
+
+int GravityEngine::add_body(glm::vec3 position, glm::vec3 velocity, float gm) {
+	int i = count++;
+
+	//Grow by a whole padding block of massless bodies at the origin
+	if (i == (int) x.size()) {
+		std::vector<float> *arrays[] = {&x, &y, &z, &this->gm, &vx, &vy, &vz, &ax, &ay, &az};
+		for (std::vector<float> *array : arrays)
+			array->resize(x.size() + GRAVITY_PADDING, 0.0f);
+	}
+
+	x[i] = position.x; y[i] = position.y; z[i] = position.z;
+	vx[i] = velocity.x; vy[i] = velocity.y; vz[i] = velocity.z;
+	this->gm[i] = gm;
+	invalidate();
+
+	return i;
+}
+
+int GravityEngine::get_count() {
+	return count;
+}
+
+glm::vec3 GravityEngine::get_position(int i) {
+	return glm::vec3(x[i], y[i], z[i]);
+}
+
+void GravityEngine::set_position(int i, glm::vec3 position) {
+	x[i] = position.x; y[i] = position.y; z[i] = position.z;
+	invalidate();
+}
+
+glm::vec3 GravityEngine::get_velocity(int i) {
+	return glm::vec3(vx[i], vy[i], vz[i]);
+}
+
+glm::vec3 GravityEngine::get_acceleration(int i) {
+	return glm::vec3(ax[i], ay[i], az[i]);
+}
+
+double GravityEngine::get_kinetic_energy() {
+	//Partial sums per chunk, added in chunk order: the same for any pool
+	std::vector<double> partials((count + BODY_GRAIN - 1) / BODY_GRAIN, 0.0);
+	for_each_range(count, BODY_GRAIN, [&](int begin, int end) {
+		double sum = 0.0;
+		for (int i = begin; i < end; i++)
+			sum += 0.5 * gm[i] * ((double) vx[i]*vx[i] + (double) vy[i]*vy[i] + (double) vz[i]*vz[i]);
+		partials[begin / BODY_GRAIN] = sum;
+	});
+
+	double sum = 0.0;
+	for (double partial : partials)
+		sum += partial;
+	return sum;
+}
+
+glm::vec3 GravityEngine::accumulate(float px, float py, float pz) {
+	glm::vec3 target(px, py, pz);
+
+	if (mode == GravityMode::BARNES_HUT) {
+		build_tree();
+		return tree->get_gravity(target, theta, softening2, kernel);
+	}
+
+	return accumulate_gravity(kernel, x.data(), y.data(), z.data(), gm.data(), (int) x.size(), target, softening2);
+}
+
+void GravityEngine::build_tree() {
+	if (tree_valid)
+		return;
+
+	tree->build(x.data(), y.data(), z.data(), gm.data(), count);
+	tree_valid = true;
+}
+
+void GravityEngine::invalidate() {
+	accelerations_valid = false;
+	tree_valid = false;
+}
+
+void GravityEngine::compute_accelerations() {
+	compute_accelerations(0, count);
+	accelerations_valid = true;
+}
+
+void GravityEngine::compute_accelerations(int begin, int end) {
+	if (mode == GravityMode::BARNES_HUT)
+		build_tree();
+
+	for_each_range(end - begin, BODY_GRAIN, [&](int first, int last) {
+		for (int i = begin + first; i < begin + last; i++) {
+			glm::vec3 a = accumulate(x[i], y[i], z[i]);
+			ax[i] = a.x; ay[i] = a.y; az[i] = a.z;
+		}
+	});
+}
+
+void GravityEngine::step(float delta_time) {
+	float half = delta_time / 2;
+
+	if (!accelerations_valid)
+		compute_accelerations();
+
+	for_each_range(count, BODY_GRAIN, [&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			vx[i] += ax[i] * half; vy[i] += ay[i] * half; vz[i] += az[i] * half;
+			x[i] += vx[i] * delta_time; y[i] += vy[i] * delta_time; z[i] += vz[i] * delta_time;
+		}
+	});
+
+	tree_valid = false;
+	compute_accelerations();
+
+	for_each_range(count, BODY_GRAIN, [&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			vx[i] += ax[i] * half; vy[i] += ay[i] * half; vz[i] += az[i] * half;
+		}
+	});
+}
+
+glm::dvec3 GravityEngine::get_gravity(glm::dvec3 target, double time) {
+	//The bodies are float
+	return glm::dvec3(accumulate((float) target.x, (float) target.y, (float) target.z));
+}
+
+void GravityEngine::get_gravity(const glm::vec3 *targets, glm::vec3 *out, int n) {
+	if (mode == GravityMode::BARNES_HUT) {
+		build_tree();
+		tree->sort_targets(targets, n, &target_order);
+		for_each_range(n, PARTICLE_GRAIN, [&](int begin, int end) {
+			tree->get_gravity(targets, target_order.data() + begin, end - begin, out, theta, softening2, kernel);
+		});
+		return;
+	}
+
+	for_each_range(n, PARTICLE_GRAIN, [&](int begin, int end) {
+		for (int i = begin; i < end; i++)
+			out[i] = accumulate(targets[i].x, targets[i].y, targets[i].z);
+	});
+}
+
+void GravityEngine::for_each_range(int n, int grain, const RangeFnT &fn) {
+	//Same chunks with or without a pool, so the results are too
+	if (jobs != nullptr)
+		jobs->parallel_for(n, grain, fn);
+	else {
+		for (int begin = 0; begin < n; begin += grain)
+			fn(begin, std::min(begin + grain, n));
+	}
+}
+
+void GravityEngine::set_jobs(JobSystem *jobs) {
+	this->jobs = jobs;
+}
+
+void GravityEngine::set_kernel(GravityKernel kernel) {
+	this->kernel = kernel;
+	accelerations_valid = false;
+}
+
+void GravityEngine::set_mode(GravityMode mode, float theta) {
+	this->mode = mode;
+	this->theta = theta;
+	accelerations_valid = false;
+}
+
+const char *GravityEngine::get_simd_name() {
+#if defined(GRAVITY_AVX2)
+	return "avx2";
+#elif defined(GRAVITY_NEON)
+	return "neon";
+#else
+	return "scalar";
+#endif
+}
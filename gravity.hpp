@@ -0,0 +1,87 @@
+#ifndef GRAVITY_HPP
+#define GRAVITY_HPP
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "integrator.hpp"
+#include "jobs.hpp"
+
+class Octree;
+
+enum class GravityKernel {
+	SCALAR,
+	SIMD, //AVX2 or NEON when built for it, scalar otherwise
+};
+
+enum class GravityMode {
+	DIRECT, //O(N^2)
+	BARNES_HUT, //O(N log N), approximate
+};
+
+const int GRAVITY_PADDING = 8; //Multiple of every SIMD width
+
+//Pull of the bodies [0, n) on `target`, skipping bodies at `target` itself. `n` must be a multiple of `GRAVITY_PADDING`.
+glm::vec3 accumulate_gravity(
+	GravityKernel kernel,
+	const float *x, const float *y, const float *z, const float *gm, int n,
+	glm::vec3 target, float softening2
+);
+
+/*
+N-body gravity on structure-of-arrays bodies.
+The arrays are padded with massless bodies up to a multiple of the SIMD width, so the kernels have no tail loop.
+*/
+class GravityEngine : public GravityField {
+public:
+	GravityEngine(float softening=0.0f);
+	~GravityEngine();
+
+	int add_body(glm::vec3 position, glm::vec3 velocity, float gm); //Returns the index
+	int get_count();
+
+	glm::vec3 get_position(int i);
+	void set_position(int i, glm::vec3 position);
+	glm::vec3 get_velocity(int i);
+	glm::vec3 get_acceleration(int i); //As of the last `compute_accelerations()`
+	double get_kinetic_energy(); //Per unit GM
+
+	void compute_accelerations(); //Of every body, from all the others
+	void compute_accelerations(int begin, int end); //Of the bodies [begin, end), from all the others
+	void step(float delta_time); //Kick-drift-kick of every body
+
+	//Test particle: feels the bodies without pulling them. `time` is ignored; the bodies stay as they are.
+	glm::dvec3 get_gravity(glm::dvec3 target, double time) override;
+	void get_gravity(const glm::vec3 *targets, glm::vec3 *out, int n); //Many test particles
+
+	void set_jobs(JobSystem *jobs); //Spreads the bodies and test particles over the pool. nullptr: single thread.
+	void set_kernel(GravityKernel kernel);
+	void set_mode(GravityMode mode, float theta=0.5f); //`theta`: Barnes-Hut opening angle (node size / distance)
+	static const char *get_simd_name(); //"avx2", "neon" or "scalar"
+
+private:
+	glm::vec3 accumulate(float px, float py, float pz);
+	void build_tree();
+	void invalidate();
+	void for_each_range(int n, int grain, const RangeFnT &fn);
+
+	int count;
+	float softening2;
+	GravityKernel kernel;
+	GravityMode mode;
+	float theta;
+	bool accelerations_valid;
+
+	JobSystem *jobs;
+
+	Octree *tree;
+	bool tree_valid; //Rebuilt on demand after the bodies move
+	std::vector<int> target_order; //Of the last test particle batch
+
+	std::vector<float> x, y, z, gm;
+	std::vector<float> vx, vy, vz;
+	std::vector<float> ax, ay, az;
+};
+
+#endif
@@ -0,0 +1,364 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp> //glm::mat4
+#include <glm/gtc/matrix_transform.hpp> //glm::rotate
+#include <algorithm> //std::max
+#include <array> //std::array
+#include <cmath> //std::abs
+
+class Transform
+{
+protected:
+	//Local space information
+	glm::vec3 m_pos = { 0.0f, 0.0f, 0.0f };
+	glm::vec3 m_eulerRot = { 0.0f, 0.0f, 0.0f }; //In degrees
+	glm::vec3 m_scale = { 1.0f, 1.0f, 1.0f };
+
+	//Global space information concatenate in matrix
+	glm::mat4 m_modelMatrix = glm::mat4(1.0f);
+
+	//Dirty flag
+	bool m_isDirty = true;
+
+protected:
+	glm::mat4 getLocalModelMatrix()
+	{
+		const glm::mat4 transformX = glm::rotate(glm::mat4(1.0f), glm::radians(m_eulerRot.x), glm::vec3(1.0f, 0.0f, 0.0f));
+		const glm::mat4 transformY = glm::rotate(glm::mat4(1.0f), glm::radians(m_eulerRot.y), glm::vec3(0.0f, 1.0f, 0.0f));
+		const glm::mat4 transformZ = glm::rotate(glm::mat4(1.0f), glm::radians(m_eulerRot.z), glm::vec3(0.0f, 0.0f, 1.0f));
+
+		// Y * X * Z
+		const glm::mat4 rotationMatrix = transformY * transformX * transformZ;
+
+		// translation * rotation * scale (also know as TRS matrix)
+		return glm::translate(glm::mat4(1.0f), m_pos) * rotationMatrix * glm::scale(glm::mat4(1.0f), m_scale);
+	}
+public:
+
+	void computeModelMatrix()
+	{
+		m_modelMatrix = getLocalModelMatrix();
+		m_isDirty = false;
+	}
+
+	void computeModelMatrix(const glm::mat4& parentGlobalModelMatrix)
+	{
+		m_modelMatrix = parentGlobalModelMatrix * getLocalModelMatrix();
+		m_isDirty = false;
+	}
+
+	void setLocalPosition(const glm::vec3& newPosition)
+	{
+		m_pos = newPosition;
+		m_isDirty = true;
+	}
+
+	void setLocalRotation(const glm::vec3& newRotation)
+	{
+		m_eulerRot = newRotation;
+		m_isDirty = true;
+	}
+
+	void setLocalScale(const glm::vec3& newScale)
+	{
+		m_scale = newScale;
+		m_isDirty = true;
+	}
+
+	glm::vec3 getGlobalPosition() const
+	{
+		return m_modelMatrix[3];
+	}
+
+	const glm::vec3& getLocalPosition() const
+	{
+		return m_pos;
+	}
+
+	const glm::vec3& getLocalRotation() const
+	{
+		return m_eulerRot;
+	}
+
+	const glm::vec3& getLocalScale() const
+	{
+		return m_scale;
+	}
+
+	const glm::mat4& getModelMatrix() const
+	{
+		return m_modelMatrix;
+	}
+
+	glm::vec3 getRight() const
+	{
+		return m_modelMatrix[0];
+	}
+
+
+	glm::vec3 getUp() const
+	{
+		return m_modelMatrix[1];
+	}
+
+	glm::vec3 getBackward() const
+	{
+		return m_modelMatrix[2];
+	}
+
+	glm::vec3 getForward() const
+	{
+		return -m_modelMatrix[2];
+	}
+
+	glm::vec3 getGlobalScale() const
+	{
+		return { glm::length(getRight()), glm::length(getUp()), glm::length(getBackward()) };
+	}
+
+	bool isDirty() const
+	{
+		return m_isDirty;
+	}
+};
+
+struct Plane
+{
+	glm::vec3 normal = { 0.f, 1.f, 0.f }; // unit vector
+	float     distance = 0.f;        // Distance with origin
+
+	Plane() = default;
+
+	Plane(const glm::vec3& p1, const glm::vec3& norm)
+		: normal(glm::normalize(norm)),
+		distance(glm::dot(normal, p1))
+	{}
+
+	float getSignedDistanceToPlane(const glm::vec3& point) const
+	{
+		return glm::dot(normal, point) - distance;
+	}
+};
+
+struct Frustum
+{
+	Plane topFace;
+	Plane bottomFace;
+
+	Plane rightFace;
+	Plane leftFace;
+
+	Plane farFace;
+	Plane nearFace;
+};
+
+struct BoundingVolume
+{
+	virtual bool isOnFrustum(const Frustum& camFrustum, const Transform& transform) const = 0;
+
+	virtual bool isOnOrForwardPlane(const Plane& plane) const = 0;
+
+	bool isOnFrustum(const Frustum& camFrustum) const
+	{
+		return (isOnOrForwardPlane(camFrustum.leftFace) &&
+			isOnOrForwardPlane(camFrustum.rightFace) &&
+			isOnOrForwardPlane(camFrustum.topFace) &&
+			isOnOrForwardPlane(camFrustum.bottomFace) &&
+			isOnOrForwardPlane(camFrustum.nearFace) &&
+			isOnOrForwardPlane(camFrustum.farFace));
+	};
+};
+
+struct Sphere : public BoundingVolume
+{
+	glm::vec3 center{ 0.f, 0.f, 0.f };
+	float radius{ 0.f };
+
+	Sphere(const glm::vec3& inCenter, float inRadius)
+		: BoundingVolume{}, center{ inCenter }, radius{ inRadius }
+	{}
+
+	using BoundingVolume::isOnFrustum;
+
+	bool isOnOrForwardPlane(const Plane& plane) const final
+	{
+		return plane.getSignedDistanceToPlane(center) > -radius;
+	}
+
+	bool isOnFrustum(const Frustum& camFrustum, const Transform& transform) const final
+	{
+		//Get global scale thanks to our transform
+		const glm::vec3 globalScale = transform.getGlobalScale();
+
+		//Get our global center with process it with the global model matrix of our transform
+		const glm::vec3 globalCenter{ transform.getModelMatrix() * glm::vec4(center, 1.f) };
+
+		//To wrap correctly our shape, we need the maximum scale scalar.
+		const float maxScale = std::max(std::max(globalScale.x, globalScale.y), globalScale.z);
+
+		//Max scale is assuming for the diameter. So, we need the half to apply it to our radius
+		Sphere globalSphere(globalCenter, radius * (maxScale * 0.5f));
+
+		//Check Firstly the result that have the most chance to failure to avoid to call all functions.
+		return (globalSphere.isOnOrForwardPlane(camFrustum.leftFace) &&
+			globalSphere.isOnOrForwardPlane(camFrustum.rightFace) &&
+			globalSphere.isOnOrForwardPlane(camFrustum.farFace) &&
+			globalSphere.isOnOrForwardPlane(camFrustum.nearFace) &&
+			globalSphere.isOnOrForwardPlane(camFrustum.topFace) &&
+			globalSphere.isOnOrForwardPlane(camFrustum.bottomFace));
+	};
+};
+
+struct SquareAABB : public BoundingVolume
+{
+	glm::vec3 center{ 0.f, 0.f, 0.f };
+	float extent{ 0.f };
+
+	SquareAABB(const glm::vec3& inCenter, float inExtent)
+		: BoundingVolume{}, center{ inCenter }, extent{ inExtent }
+	{}
+
+	using BoundingVolume::isOnFrustum;
+
+	bool isOnOrForwardPlane(const Plane& plane) const final
+	{
+		// Compute the projection interval radius of b onto L(t) = b.c + t * p.n
+		const float r = extent * (std::abs(plane.normal.x) + std::abs(plane.normal.y) + std::abs(plane.normal.z));
+		return -r <= plane.getSignedDistanceToPlane(center);
+	}
+
+	bool isOnFrustum(const Frustum& camFrustum, const Transform& transform) const final
+	{
+		//Get global scale thanks to our transform
+		const glm::vec3 globalCenter{ transform.getModelMatrix() * glm::vec4(center, 1.f) };
+
+		// Scaled orientation
+		const glm::vec3 right = transform.getRight() * extent;
+		const glm::vec3 up = transform.getUp() * extent;
+		const glm::vec3 forward = transform.getForward() * extent;
+
+		const float newIi = std::abs(glm::dot(glm::vec3{ 1.f, 0.f, 0.f }, right)) +
+			std::abs(glm::dot(glm::vec3{ 1.f, 0.f, 0.f }, up)) +
+			std::abs(glm::dot(glm::vec3{ 1.f, 0.f, 0.f }, forward));
+
+		const float newIj = std::abs(glm::dot(glm::vec3{ 0.f, 1.f, 0.f }, right)) +
+			std::abs(glm::dot(glm::vec3{ 0.f, 1.f, 0.f }, up)) +
+			std::abs(glm::dot(glm::vec3{ 0.f, 1.f, 0.f }, forward));
+
+		const float newIk = std::abs(glm::dot(glm::vec3{ 0.f, 0.f, 1.f }, right)) +
+			std::abs(glm::dot(glm::vec3{ 0.f, 0.f, 1.f }, up)) +
+			std::abs(glm::dot(glm::vec3{ 0.f, 0.f, 1.f }, forward));
+
+		const SquareAABB globalAABB(globalCenter, std::max(std::max(newIi, newIj), newIk));
+
+		return (globalAABB.isOnOrForwardPlane(camFrustum.leftFace) &&
+			globalAABB.isOnOrForwardPlane(camFrustum.rightFace) &&
+			globalAABB.isOnOrForwardPlane(camFrustum.topFace) &&
+			globalAABB.isOnOrForwardPlane(camFrustum.bottomFace) &&
+			globalAABB.isOnOrForwardPlane(camFrustum.nearFace) &&
+			globalAABB.isOnOrForwardPlane(camFrustum.farFace));
+	};
+};
+
+struct AABB : public BoundingVolume
+{
+	glm::vec3 center{ 0.f, 0.f, 0.f };
+	glm::vec3 extents{ 0.f, 0.f, 0.f };
+
+	AABB(const glm::vec3& min, const glm::vec3& max)
+		: BoundingVolume{}, center{ (max + min) * 0.5f }, extents{ max.x - center.x, max.y - center.y, max.z - center.z }
+	{}
+
+	AABB(const glm::vec3& inCenter, float iI, float iJ, float iK)
+		: BoundingVolume{}, center{ inCenter }, extents{ iI, iJ, iK }
+	{}
+
+	using BoundingVolume::isOnFrustum;
+
+	std::array<glm::vec3, 8> getVertice() const
+	{
+		std::array<glm::vec3, 8> vertice;
+		vertice[0] = { center.x - extents.x, center.y - extents.y, center.z - extents.z };
+		vertice[1] = { center.x + extents.x, center.y - extents.y, center.z - extents.z };
+		vertice[2] = { center.x - extents.x, center.y + extents.y, center.z - extents.z };
+		vertice[3] = { center.x + extents.x, center.y + extents.y, center.z - extents.z };
+		vertice[4] = { center.x - extents.x, center.y - extents.y, center.z + extents.z };
+		vertice[5] = { center.x + extents.x, center.y - extents.y, center.z + extents.z };
+		vertice[6] = { center.x - extents.x, center.y + extents.y, center.z + extents.z };
+		vertice[7] = { center.x + extents.x, center.y + extents.y, center.z + extents.z };
+		return vertice;
+	}
+
+	//see https://gdbooks.gitbooks.io/3dcollisions/content/Chapter2/static_aabb_plane.html
+	bool isOnOrForwardPlane(const Plane& plane) const final
+	{
+		// Compute the projection interval radius of b onto L(t) = b.c + t * p.n
+		const float r = extents.x * std::abs(plane.normal.x) + extents.y * std::abs(plane.normal.y) +
+			extents.z * std::abs(plane.normal.z);
+
+		return -r <= plane.getSignedDistanceToPlane(center);
+	}
+
+	bool isOnFrustum(const Frustum& camFrustum, const Transform& transform) const final
+	{
+		//Get global scale thanks to our transform
+		const glm::vec3 globalCenter{ transform.getModelMatrix() * glm::vec4(center, 1.f) };
+
+		// Scaled orientation
+		const glm::vec3 right = transform.getRight() * extents.x;
+		const glm::vec3 up = transform.getUp() * extents.y;
+		const glm::vec3 forward = transform.getForward() * extents.z;
+
+		const float newIi = std::abs(glm::dot(glm::vec3{ 1.f, 0.f, 0.f }, right)) +
+			std::abs(glm::dot(glm::vec3{ 1.f, 0.f, 0.f }, up)) +
+			std::abs(glm::dot(glm::vec3{ 1.f, 0.f, 0.f }, forward));
+
+		const float newIj = std::abs(glm::dot(glm::vec3{ 0.f, 1.f, 0.f }, right)) +
+			std::abs(glm::dot(glm::vec3{ 0.f, 1.f, 0.f }, up)) +
+			std::abs(glm::dot(glm::vec3{ 0.f, 1.f, 0.f }, forward));
+
+		const float newIk = std::abs(glm::dot(glm::vec3{ 0.f, 0.f, 1.f }, right)) +
+			std::abs(glm::dot(glm::vec3{ 0.f, 0.f, 1.f }, up)) +
+			std::abs(glm::dot(glm::vec3{ 0.f, 0.f, 1.f }, forward));
+
+		const AABB globalAABB(globalCenter, newIi, newIj, newIk);
+
+		return (globalAABB.isOnOrForwardPlane(camFrustum.leftFace) &&
+			globalAABB.isOnOrForwardPlane(camFrustum.rightFace) &&
+			globalAABB.isOnOrForwardPlane(camFrustum.topFace) &&
+			globalAABB.isOnOrForwardPlane(camFrustum.bottomFace) &&
+			globalAABB.isOnOrForwardPlane(camFrustum.nearFace) &&
+			globalAABB.isOnOrForwardPlane(camFrustum.farFace));
+	};
+};
+
+//Planes of the frustum of a projection * view matrix (Gribb & Hartmann), facing inwards
+inline Frustum createFrustumFromMatrix(const glm::mat4& m)
+{
+	//Rows of the matrix; glm is column major
+	const glm::vec4 row0{ m[0][0], m[1][0], m[2][0], m[3][0] };
+	const glm::vec4 row1{ m[0][1], m[1][1], m[2][1], m[3][1] };
+	const glm::vec4 row2{ m[0][2], m[1][2], m[2][2], m[3][2] };
+	const glm::vec4 row3{ m[0][3], m[1][3], m[2][3], m[3][3] };
+
+	//ax + by + cz + d >= 0 inside, normalized
+	const auto toPlane = [](const glm::vec4& p)
+	{
+		Plane plane;
+		const float length = glm::length(glm::vec3(p));
+		plane.normal = glm::vec3(p) / length;
+		plane.distance = -p.w / length;
+		return plane;
+	};
+
+	Frustum frustum;
+	frustum.leftFace = toPlane(row3 + row0);
+	frustum.rightFace = toPlane(row3 - row0);
+	frustum.bottomFace = toPlane(row3 + row1);
+	frustum.topFace = toPlane(row3 - row1);
+	frustum.nearFace = toPlane(row3 + row2);
+	frustum.farFace = toPlane(row3 - row2);
+	return frustum;
+}
+#endif
@@ -0,0 +1,127 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+
+// shadow of the bound program, vertex array and textures: binding what's already bound issues no GL call.
+// every bind of these has to go through it, or the shadow goes stale; deleting through it forgets names GL may hand out again.
+// ------------------------------------------------------------------------
+class GLState
+{
+public:
+    static void useProgram(unsigned int program)
+    {
+        State &s = state();
+        if (s.program == program)
+        {
+            s.skipped++;
+            return;
+        }
+        s.program = program;
+        s.issued++;
+        glUseProgram(program);
+    }
+    // ------------------------------------------------------------------------
+    static void bindVertexArray(unsigned int VAO)
+    {
+        State &s = state();
+        if (s.vertexArray == VAO)
+        {
+            s.skipped++;
+            return;
+        }
+        s.vertexArray = VAO;
+        s.issued++;
+        glBindVertexArray(VAO);
+    }
+    // unit: GL_TEXTURE0 + i, as glActiveTexture
+    // ------------------------------------------------------------------------
+    static void activeTexture(GLenum unit)
+    {
+        State &s = state();
+        unsigned int i = unit - GL_TEXTURE0;
+        if (s.activeUnit == i)
+        {
+            s.skipped++;
+            return;
+        }
+        s.activeUnit = i;
+        s.issued++;
+        glActiveTexture(unit);
+    }
+    // to the active unit; targets other than 2D, cube map and buffer aren't tracked
+    // ------------------------------------------------------------------------
+    static void bindTexture(GLenum target, unsigned int texture)
+    {
+        State &s = state();
+        int t = targetIndex(target);
+        if (t < 0 || s.activeUnit >= MAX_UNITS)
+        {
+            s.issued++;
+            glBindTexture(target, texture);
+            return;
+        }
+        if (s.textures[s.activeUnit][t] == texture)
+        {
+            s.skipped++;
+            return;
+        }
+        s.textures[s.activeUnit][t] = texture;
+        s.issued++;
+        glBindTexture(target, texture);
+    }
+    // GL unbinds what it deletes
+    // ------------------------------------------------------------------------
+    static void deleteVertexArray(unsigned int VAO)
+    {
+        State &s = state();
+        if (s.vertexArray == VAO)
+            s.vertexArray = 0;
+        glDeleteVertexArrays(1, &VAO);
+    }
+    static void deleteTexture(unsigned int texture)
+    {
+        State &s = state();
+        for (unsigned int i = 0; i < MAX_UNITS; i++)
+            for (int t = 0; t < TARGET_COUNT; t++)
+                if (s.textures[i][t] == texture)
+                    s.textures[i][t] = 0;
+        glDeleteTextures(1, &texture);
+    }
+    // binds since the last reset, issued to GL and skipped as redundant
+    // ------------------------------------------------------------------------
+    static unsigned int getIssuedCount() { return state().issued; }
+    static unsigned int getSkippedCount() { return state().skipped; }
+    static void resetCounts() { state().issued = state().skipped = 0; }
+
+private:
+    static const unsigned int MAX_UNITS = 32;
+    enum { TARGET_2D, TARGET_CUBE_MAP, TARGET_BUFFER, TARGET_COUNT };
+
+    // GL's defaults: everything 0, unit 0 active
+    struct State
+    {
+        unsigned int program;
+        unsigned int vertexArray;
+        unsigned int activeUnit;
+        unsigned int textures[MAX_UNITS][TARGET_COUNT];
+        unsigned int issued, skipped;
+    };
+
+    static State &state()
+    {
+        static State s = {};
+        return s;
+    }
+    static int targetIndex(GLenum target)
+    {
+        switch (target)
+        {
+        case GL_TEXTURE_2D: return TARGET_2D;
+        case GL_TEXTURE_CUBE_MAP: return TARGET_CUBE_MAP;
+        case GL_TEXTURE_BUFFER: return TARGET_BUFFER;
+        default: return -1;
+        }
+    }
+};
+#endif
@@ -6,6 +6,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <learnopengl/gl_state.h>
 #include <learnopengl/shader.h>
 
 #include <string>
@@ -37,6 +38,19 @@ struct Texture {
     string path;
 };
 
+// a texture of a mesh, as bound for one shader: no names left
+struct TextureBinding {
+    int location;      // of the sampler ("texture_diffuse1"...), -1 if the shader doesn't use it
+    unsigned int unit; // texture unit, the texture's index in the mesh
+    unsigned int id;
+};
+
+// the textures of a mesh resolved for one shader program, once
+struct MaterialBinding {
+    unsigned int program;
+    vector<TextureBinding> textures;
+};
+
 class Mesh {
 public:
     // mesh Data
@@ -56,17 +70,48 @@ public:
         setupMesh();
     }
 
-    // render the mesh
+    // render the mesh; the textures are resolved on the first draw with each shader, so later draws don't allocate nor look up names
     void Draw(Shader &shader) 
     {
         // bind appropriate textures
+        const MaterialBinding &binding = getMaterialBinding(shader);
+        for(const TextureBinding &texture : binding.textures)
+        {
+            GLState::activeTexture(GL_TEXTURE0 + texture.unit); // active proper texture unit before binding
+            // now set the sampler to the correct texture unit; other meshes may have put theirs elsewhere
+            if(texture.location != -1)
+                glUniform1i(texture.location, texture.unit);
+            // and finally bind the texture
+            GLState::bindTexture(GL_TEXTURE_2D, texture.id);
+        }
+        
+        // draw mesh; the next draw binds what it needs, so nothing is set back
+        GLState::bindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
+    }
+
+private:
+    // render data 
+    unsigned int VBO, EBO;
+    vector<MaterialBinding> materialBindings; // one per shader this mesh was drawn with
+
+    // finds the textures' binding for the shader, resolving it on the first draw with it
+    const MaterialBinding &getMaterialBinding(const Shader &shader)
+    {
+        for(const MaterialBinding &binding : materialBindings)
+        {
+            if(binding.program == shader.ID)
+                return binding;
+        }
+
+        MaterialBinding binding;
+        binding.program = shader.ID;
         unsigned int diffuseNr  = 1;
         unsigned int specularNr = 1;
         unsigned int normalNr   = 1;
         unsigned int heightNr   = 1;
         for(unsigned int i = 0; i < textures.size(); i++)
         {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
             // retrieve texture number (the N in diffuse_textureN)
             string number;
             string name = textures[i].type;
@@ -79,25 +124,16 @@ public:
              else if(name == "texture_height")
                 number = std::to_string(heightNr++); // transfer unsigned int to string
 
-            // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+            TextureBinding texture;
+            texture.location = glGetUniformLocation(shader.ID, (name + number).c_str());
+            texture.unit = i;
+            texture.id = textures[i].id;
+            binding.textures.push_back(texture);
         }
-        
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
+        materialBindings.push_back(binding);
+        return materialBindings.back();
     }
 
-private:
-    // render data 
-    unsigned int VBO, EBO;
-
     // initializes all the buffer objects/arrays
     void setupMesh()
     {
@@ -106,7 +142,7 @@ private:
         glGenBuffers(1, &VBO);
         glGenBuffers(1, &EBO);
 
-        glBindVertexArray(VAO);
+        GLState::bindVertexArray(VAO);
         // load data into vertex buffers
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
         // A great thing about structs is that their memory layout is sequential for all its items.
@@ -140,7 +176,7 @@ private:
 		// weights
 		glEnableVertexAttribArray(6);
 		glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
-        glBindVertexArray(0);
+        GLState::bindVertexArray(0);
     }
 };
 #endif
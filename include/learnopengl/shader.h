@@ -4,6 +4,8 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <learnopengl/gl_state.h>
+
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -100,7 +102,7 @@ public:
     // ------------------------------------------------------------------------
     void use() 
     { 
-        glUseProgram(ID); 
+        GLState::useProgram(ID); 
     }
     // utility uniform functions
     // ------------------------------------------------------------------------
@@ -4,18 +4,30 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <learnopengl/gl_state.h>
+
+#include <algorithm>
 #include <string>
+#include <vector>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
+// typed handle to a uniform: resolve it once with Shader::getUniform<T>() and reuse it every frame
+// ------------------------------------------------------------------------
+template <typename T>
+struct Uniform
+{
+    int location = -1; // -1 if the program doesn't use it; setting it is then a no-op, as in GL
+};
+
 class Shader
 {
 public:
     unsigned int ID;
-    // constructor generates the shader on the fly
+    // constructor generates the shader on the fly; `defines` ("#define X\n"...) go right after the #version line of both stages
     // ------------------------------------------------------------------------
-    Shader(const char* vertexPath, const char* fragmentPath)
+    Shader(const char* vertexPath, const char* fragmentPath, const std::string &defines = std::string())
     {
         // 1. retrieve the vertex/fragment source code from filePath
         std::string vertexCode;
@@ -38,8 +50,8 @@ public:
             vShaderFile.close();
             fShaderFile.close();
             // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();			
+            vertexCode = injectDefines(vShaderStream.str(), defines);
+            fragmentCode = injectDefines(fShaderStream.str(), defines);
         }
         catch (std::ifstream::failure& e)
         {
@@ -68,74 +80,199 @@ public:
         // delete the shaders as they're linked into our program now and no longer necessary
         glDeleteShader(vertex);
         glDeleteShader(fragment);
-
+        // 3. reflect the active uniforms, so no location is queried from GL after this
+        reflectUniforms();
     }
-    // activate the shader
+    // activate the shader; a no-op if it's already active
     // ------------------------------------------------------------------------
     void use() const
     { 
-        glUseProgram(ID); 
+        GLState::useProgram(ID); 
+    }
+    // resolves a uniform by name, once; the handle is then set without any lookup
+    // ------------------------------------------------------------------------
+    template <typename T>
+    Uniform<T> getUniform(const std::string &name) const
+    {
+        Uniform<T> uniform;
+        uniform.location = findUniform(name);
+        return uniform;
     }
-    // utility uniform functions
+    // typed uniform functions, through handles
+    // ------------------------------------------------------------------------
+    void set(Uniform<bool> uniform, bool value) const { glUniform1i(uniform.location, (int)value); }
+    void set(Uniform<int> uniform, int value) const { glUniform1i(uniform.location, value); }
+    void set(Uniform<float> uniform, float value) const { glUniform1f(uniform.location, value); }
+    void set(Uniform<glm::vec2> uniform, const glm::vec2 &value) const { glUniform2fv(uniform.location, 1, &value[0]); }
+    void set(Uniform<glm::vec3> uniform, const glm::vec3 &value) const { glUniform3fv(uniform.location, 1, &value[0]); }
+    void set(Uniform<glm::vec4> uniform, const glm::vec4 &value) const { glUniform4fv(uniform.location, 1, &value[0]); }
+    void set(Uniform<glm::mat2> uniform, const glm::mat2 &mat) const { glUniformMatrix2fv(uniform.location, 1, GL_FALSE, &mat[0][0]); }
+    void set(Uniform<glm::mat3> uniform, const glm::mat3 &mat) const { glUniformMatrix3fv(uniform.location, 1, GL_FALSE, &mat[0][0]); }
+    void set(Uniform<glm::mat4> uniform, const glm::mat4 &mat) const { glUniformMatrix4fv(uniform.location, 1, GL_FALSE, &mat[0][0]); }
+    // points a uniform block to a binding point of GL_UNIFORM_BUFFER; blocks the program doesn't use are skipped
+    // ------------------------------------------------------------------------
+    void bindBlock(const std::string &name, unsigned int binding) const
+    {
+        unsigned int index = glGetUniformBlockIndex(ID, name.c_str());
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(ID, index, binding);
+    }
+    // lookups by name (getUniform() and the functions below) of every shader since the last reset; 0 at steady state
+    // ------------------------------------------------------------------------
+    static unsigned int getLookupCount() { return lookupCount(); }
+    static void resetLookupCount() { lookupCount() = 0; }
+    // utility uniform functions, by name: a lookup in the reflected table each
     // ------------------------------------------------------------------------
     void setBool(const std::string &name, bool value) const
     {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+        glUniform1i(findUniform(name), (int)value); 
     }
     // ------------------------------------------------------------------------
     void setInt(const std::string &name, int value) const
     { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+        glUniform1i(findUniform(name), value); 
     }
     // ------------------------------------------------------------------------
     void setFloat(const std::string &name, float value) const
     { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+        glUniform1f(findUniform(name), value); 
     }
     // ------------------------------------------------------------------------
     void setVec2(const std::string &name, const glm::vec2 &value) const
     { 
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform2fv(findUniform(name), 1, &value[0]); 
     }
     void setVec2(const std::string &name, float x, float y) const
     { 
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
+        glUniform2f(findUniform(name), x, y); 
     }
     // ------------------------------------------------------------------------
     void setVec3(const std::string &name, const glm::vec3 &value) const
     { 
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform3fv(findUniform(name), 1, &value[0]); 
     }
     void setVec3(const std::string &name, float x, float y, float z) const
     { 
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
+        glUniform3f(findUniform(name), x, y, z); 
     }
     // ------------------------------------------------------------------------
     void setVec4(const std::string &name, const glm::vec4 &value) const
     { 
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform4fv(findUniform(name), 1, &value[0]); 
     }
     void setVec4(const std::string &name, float x, float y, float z, float w) const
     { 
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
+        glUniform4f(findUniform(name), x, y, z, w); 
     }
     // ------------------------------------------------------------------------
     void setMat2(const std::string &name, const glm::mat2 &mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix2fv(findUniform(name), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat3(const std::string &name, const glm::mat3 &mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix3fv(findUniform(name), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat4(const std::string &name, const glm::mat4 &mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix4fv(findUniform(name), 1, GL_FALSE, &mat[0][0]);
     }
 
 private:
+    // open addressing table of the active uniforms, a power of two in size; empty names are free slots
+    struct UniformSlot
+    {
+        unsigned int hash;
+        int location;
+        std::string name;
+    };
+    std::vector<UniformSlot> uniformSlots;
+
+    static unsigned int &lookupCount()
+    {
+        static unsigned int count = 0;
+        return count;
+    }
+    // FNV-1a
+    static unsigned int hashName(const char *name)
+    {
+        unsigned int hash = 2166136261u;
+        for (; *name != '\0'; name++)
+            hash = (hash ^ (unsigned char)*name) * 16777619u;
+        return hash;
+    }
+    // fills the table once, after linking
+    // ------------------------------------------------------------------------
+    void reflectUniforms()
+    {
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+        // at most half full, arrays taking two slots ("name[0]" and "name")
+        size_t size = 16;
+        while (size < (size_t)count * 4)
+            size *= 2;
+        uniformSlots.assign(size, UniformSlot{0, -1, std::string()});
+
+        std::vector<GLchar> buffer(maxLength > 0 ? maxLength : 1);
+        for (GLint i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            GLint arraySize = 0;
+            GLenum type;
+            glGetActiveUniform(ID, (GLuint)i, (GLsizei)buffer.size(), &length, &arraySize, &type, buffer.data());
+            std::string name(buffer.data(), length);
+            int location = glGetUniformLocation(ID, name.c_str());
+            if (location < 0)
+                continue; // in a uniform block
+            insertUniform(name, location);
+            if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+                insertUniform(name.substr(0, name.size() - 3), location);
+        }
+    }
+    void insertUniform(const std::string &name, int location)
+    {
+        unsigned int hash = hashName(name.c_str());
+        size_t mask = uniformSlots.size() - 1;
+        size_t i = hash & mask;
+        while (!uniformSlots[i].name.empty())
+            i = (i + 1) & mask;
+        uniformSlots[i] = UniformSlot{hash, location, name};
+    }
+    int findUniform(const std::string &name) const
+    {
+        lookupCount()++;
+        if (uniformSlots.empty())
+            return -1;
+        unsigned int hash = hashName(name.c_str());
+        size_t mask = uniformSlots.size() - 1;
+        for (size_t i = hash & mask; !uniformSlots[i].name.empty(); i = (i + 1) & mask)
+        {
+            if (uniformSlots[i].hash == hash && uniformSlots[i].name == name)
+                return uniformSlots[i].location;
+        }
+        return -1;
+    }
+
+    // the #version line has to stay first; #line keeps the compiler's line numbers those of the file
+    // ------------------------------------------------------------------------
+    static std::string injectDefines(const std::string &code, const std::string &defines)
+    {
+        if (defines.empty())
+            return code;
+        size_t version = code.find("#version");
+        if (version == std::string::npos)
+            return defines + "#line 1\n" + code;
+        size_t end = code.find('\n', version);
+        if (end == std::string::npos)
+            return code + "\n" + defines;
+        size_t line = std::count(code.begin(), code.begin() + end, '\n') + 2; // of the line after #version
+        return code.substr(0, end + 1) + defines + "#line " + std::to_string(line) + "\n" + code.substr(end + 1);
+    }
+
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(GLuint shader, std::string type)
@@ -162,4 +299,52 @@ private:
         }
     }
 };
+
+// the variants of one shader, by feature mask: bit i #defines features[i].
+// each variant is compiled the first time it's asked for, then reused
+// ------------------------------------------------------------------------
+class ShaderPermutations
+{
+public:
+    ShaderPermutations(const char* vertexPath, const char* fragmentPath, const std::vector<std::string> &features)
+        : vertexPath(vertexPath), fragmentPath(fragmentPath), features(features)
+    {
+    }
+    ~ShaderPermutations()
+    {
+        for (Variant &variant : variants)
+            delete variant.shader;
+    }
+    ShaderPermutations(const ShaderPermutations &) = delete;
+    ShaderPermutations &operator=(const ShaderPermutations &) = delete;
+
+    Shader *get(unsigned int mask)
+    {
+        for (const Variant &variant : variants)
+        {
+            if (variant.mask == mask)
+                return variant.shader;
+        }
+
+        std::string defines;
+        for (size_t i = 0; i < features.size(); i++)
+        {
+            if (mask & (1u << i))
+                defines += "#define " + features[i] + "\n";
+        }
+        variants.push_back(Variant{mask, new Shader(vertexPath.c_str(), fragmentPath.c_str(), defines)});
+        return variants.back().shader;
+    }
+
+private:
+    struct Variant
+    {
+        unsigned int mask;
+        Shader *shader;
+    };
+
+    std::string vertexPath, fragmentPath;
+    std::vector<std::string> features;
+    std::vector<Variant> variants;
+};
 #endif
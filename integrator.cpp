@@ -0,0 +1,196 @@
+#include "integrator.hpp"
+
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include "utils.hpp"
+
+PointMass::PointMass(glm::dvec3 position, double gm) : position(position), gm(gm) {}
+
+glm::dvec3 PointMass::get_gravity(glm::dvec3 target, double time) {
+	glm::dvec3 diff = position - target;
+	double dist2 = glm::dot(diff, diff);
+	return diff * (gm / (dist2 * std::sqrt(dist2)));
+}
+
+//v += a(x) dt; x += v dt
+class SemiImplicitEuler : public Integrator {
+public:
+	void step(BodyState *state, double time, float delta_time, GravityField *field) override {
+		double h = delta_time;
+		state->velocity += field->get_gravity(state->position, time) * h;
+		state->position += state->velocity * h;
+	}
+	int get_evals_per_step() override {return 1;}
+};
+
+/*
+Kick-drift-kick.
+The acceleration at the end of a step is the one at the start of the next, unless the state was moved in between.
+*/
+class VelocityVerlet : public Integrator {
+public:
+	VelocityVerlet() : cached(false) {}
+
+	void step(BodyState *state, double time, float delta_time, GravityField *field) override {
+		double h = delta_time;
+		glm::dvec3 accel;
+		if (cached && cached_position == state->position && cached_time == time)
+			accel = cached_accel;
+		else
+			accel = field->get_gravity(state->position, time);
+
+		state->velocity += accel * (h / 2);
+		state->position += state->velocity * h;
+
+		cached_time = time + h;
+		cached_position = state->position;
+		cached_accel = field->get_gravity(state->position, cached_time);
+		cached = true;
+
+		state->velocity += cached_accel * (h / 2);
+	}
+	int get_evals_per_step() override {return 1;}
+
+private:
+	bool cached;
+	double cached_time;
+	glm::dvec3 cached_position;
+	glm::dvec3 cached_accel;
+};
+
+class RK4 : public Integrator {
+public:
+	void step(BodyState *state, double time, float delta_time, GravityField *field) override {
+		double h = delta_time;
+		glm::dvec3 x = state->position, v = state->velocity;
+
+		glm::dvec3 k1x = v;
+		glm::dvec3 k1v = field->get_gravity(x, time);
+		glm::dvec3 k2x = v + k1v * (h/2);
+		glm::dvec3 k2v = field->get_gravity(x + k1x * (h/2), time + h/2);
+		glm::dvec3 k3x = v + k2v * (h/2);
+		glm::dvec3 k3v = field->get_gravity(x + k2x * (h/2), time + h/2);
+		glm::dvec3 k4x = v + k3v * h;
+		glm::dvec3 k4v = field->get_gravity(x + k3x * h, time + h);
+
+		state->position += (k1x + 2.0*k2x + 2.0*k3x + k4x) * (h/6);
+		state->velocity += (k1v + 2.0*k2v + 2.0*k3v + k4v) * (h/6);
+	}
+	int get_evals_per_step() override {return 4;}
+};
+
+//Forest-Ruth: three Verlet steps of `theta`, `1 - 2*theta`, `theta` (Yoshida's composition)
+class ForestRuth : public Integrator {
+public:
+	void step(BodyState *state, double time, float delta_time, GravityField *field) override {
+		const double THETA = 1.0 / (2.0 - std::cbrt(2.0));
+		double h = delta_time;
+		double t = time;
+
+		state->position += state->velocity * (THETA * h/2);
+		t += THETA * h/2;
+		state->velocity += field->get_gravity(state->position, t) * (THETA * h);
+
+		state->position += state->velocity * ((1 - THETA) * h/2);
+		t += (1 - THETA) * h/2;
+		state->velocity += field->get_gravity(state->position, t) * ((1 - 2*THETA) * h);
+
+		state->position += state->velocity * ((1 - THETA) * h/2);
+		t += (1 - THETA) * h/2;
+		state->velocity += field->get_gravity(state->position, t) * (THETA * h);
+
+		state->position += state->velocity * (THETA * h/2);
+	}
+	int get_evals_per_step() override {return 3;}
+};
+
+static const IntegratorType INTEGRATOR_TYPES[] = {
+	IntegratorType::SEMI_IMPLICIT_EULER,
+	IntegratorType::VELOCITY_VERLET,
+	IntegratorType::RK4,
+	IntegratorType::FOREST_RUTH,
+};
+
+Integrator *new_integrator(IntegratorType type) {
+	switch (type) {
+	case IntegratorType::VELOCITY_VERLET:
+		return new VelocityVerlet();
+	case IntegratorType::RK4:
+		return new RK4();
+	case IntegratorType::FOREST_RUTH:
+		return new ForestRuth();
+	case IntegratorType::SEMI_IMPLICIT_EULER:
+	default:
+		return new SemiImplicitEuler();
+	}
+}
+
+bool parse_integrator_type(const char *name, IntegratorType *type) {
+	for (IntegratorType t : INTEGRATOR_TYPES) {
+		if (std::strcmp(name, get_integrator_name(t)) == 0) {
+			*type = t;
+			return true;
+		}
+	}
+	return false;
+}
+
+const char *get_integrator_name(IntegratorType type) {
+	switch (type) {
+	case IntegratorType::VELOCITY_VERLET:
+		return "velocity-verlet";
+	case IntegratorType::RK4:
+		return "rk4";
+	case IntegratorType::FOREST_RUTH:
+		return "forest-ruth";
+	case IntegratorType::SEMI_IMPLICIT_EULER:
+	default:
+		return "semi-implicit-euler";
+	}
+}
+
+DriftReport measure_drift(Integrator *integrator, float gm, float periapsis, float eccentricity, float delta_time, float orbits) {
+	PointMass field(glm::dvec3(0.0), gm);
+
+	//Starts at the periapsis, moving perpendicular to the radius (vis-viva)
+	BodyState state;
+	state.position = glm::dvec3(periapsis, 0.0, 0.0);
+	state.velocity = glm::dvec3(0.0, 0.0, std::sqrt((double) gm * (1 + eccentricity) / periapsis));
+
+	double a = periapsis / (1.0 - eccentricity);
+	double period = 2*PI * std::sqrt(a*a*a / gm);
+
+	auto energy = [gm](const BodyState &s) {
+		return glm::dot(s.velocity, s.velocity) / 2 - gm / glm::length(s.position);
+	};
+	auto angular_momentum = [](const BodyState &s) {
+		return glm::length(glm::cross(s.position, s.velocity));
+	};
+	double e0 = energy(state), l0 = angular_momentum(state);
+
+	DriftReport report = {0.0, 0.0, 0, 0.0};
+	report.steps = (long long) (orbits * period / delta_time);
+
+	BodyState initial_state = state;
+	for (long long i = 0; i < report.steps; i++) {
+		integrator->step(&state, i * (double) delta_time, delta_time, &field);
+
+		double e = std::abs((energy(state) - e0) / e0);
+		double l = std::abs((angular_momentum(state) - l0) / l0);
+		if (e > report.energy_drift) report.energy_drift = e;
+		if (l > report.angular_momentum_drift) report.angular_momentum_drift = l;
+	}
+
+	//Again without the measurement, for the cost
+	state = initial_state;
+	auto start = std::chrono::steady_clock::now();
+	for (long long i = 0; i < report.steps; i++)
+		integrator->step(&state, i * (double) delta_time, delta_time, &field);
+	report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return report;
+}
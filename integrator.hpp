@@ -0,0 +1,63 @@
+#ifndef INTEGRATOR_HPP
+#define INTEGRATOR_HPP
+
+#include <glm/glm.hpp>
+
+//In double, so positions far from the origin keep their precision; relative quantities go back to float
+struct BodyState {
+	glm::dvec3 position;
+	glm::dvec3 velocity;
+};
+
+//Anything that pulls: the acceleration a body at `target` feels at `time`
+class GravityField {
+public:
+	virtual glm::dvec3 get_gravity(glm::dvec3 target, double time) = 0;
+};
+
+//Fixed point mass, for measurements
+class PointMass : public GravityField {
+public:
+	PointMass(glm::dvec3 position, double gm);
+	glm::dvec3 get_gravity(glm::dvec3 target, double time) override;
+
+private:
+	glm::dvec3 position;
+	double gm;
+};
+
+enum class IntegratorType {
+	SEMI_IMPLICIT_EULER,
+	VELOCITY_VERLET,
+	RK4,
+	FOREST_RUTH, //4th-order Yoshida
+};
+
+class Integrator {
+public:
+	virtual ~Integrator() {}
+
+	//Advances `state` from `time` to `time + delta_time`
+	virtual void step(BodyState *state, double time, float delta_time, GravityField *field) = 0;
+	virtual int get_evals_per_step() = 0; //# of `get_gravity()` calls
+};
+
+Integrator *new_integrator(IntegratorType type);
+bool parse_integrator_type(const char *name, IntegratorType *type); //false on unknown names
+const char *get_integrator_name(IntegratorType type);
+
+/*
+Energy and angular momentum drift of a Kepler orbit around a `PointMass`.
+The orbit starts at the periapsis `periapsis` with the eccentricity `eccentricity` and runs for `orbits` periods.
+Drifts are the max. relative errors over the run.
+*/
+struct DriftReport {
+	double energy_drift;
+	double angular_momentum_drift;
+	long long steps;
+	double seconds; //Wall clock of the steps alone
+};
+
+DriftReport measure_drift(Integrator *integrator, float gm, float periapsis, float eccentricity, float delta_time, float orbits);
+
+#endif
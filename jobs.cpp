@@ -0,0 +1,150 @@
+#include "jobs.hpp"
+
+#include <algorithm>
+
+//Pool and queue of the current thread, if it is a worker
+static thread_local JobSystem *worker_pool = nullptr;
+static thread_local int worker_index = 0;
+
+JobSystem::JobSystem(int thread_count) {
+	if (thread_count <= 0)
+		thread_count = std::max(1, (int) std::thread::hardware_concurrency());
+	this->thread_count = thread_count;
+
+	pending = 0;
+	next_async = 0;
+	quit = false;
+
+	for (int i = 0; i < thread_count; i++)
+		queues.push_back(new Queue());
+	for (int i = 1; i < thread_count; i++)
+		threads.push_back(std::thread(&JobSystem::worker_loop, this, i));
+}
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		quit = true;
+	}
+	wake.notify_all();
+
+	for (std::thread &thread : threads)
+		thread.join();
+	for (Queue *queue : queues)
+		delete queue;
+}
+
+void JobSystem::parallel_for(int count, int grain, const RangeFnT &fn) {
+	if (count <= 0)
+		return;
+	grain = std::max(grain, 1);
+
+	int chunks = (count + grain - 1) / grain;
+	if (chunks == 1 || thread_count == 1) {
+		for (int begin = 0; begin < count; begin += grain)
+			fn(begin, std::min(begin + grain, count));
+		return;
+	}
+
+	std::atomic<int> remaining(chunks);
+
+	//Deal the chunks out round-robin; stealing evens out the rest
+	for (int c = 0; c < chunks; c++) {
+		Job job = {&fn, c * grain, std::min((c + 1) * grain, count), &remaining, nullptr};
+		Queue *queue = queues[c % thread_count];
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		queue->jobs.push_back(job);
+	}
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		pending += chunks;
+	}
+	wake.notify_all();
+
+	//Help until the chunks are done
+	int index = (worker_pool == this) ? worker_index : 0;
+	while (remaining.load() > 0) {
+		if (!run_one(index))
+			std::this_thread::yield();
+	}
+}
+
+void JobSystem::run_async(const TaskFnT &fn) {
+	if (thread_count == 1) {
+		fn();
+		return;
+	}
+
+	Job job = {nullptr, 0, 0, nullptr, new TaskFnT(fn)};
+	Queue *queue = queues[1 + next_async++ % (thread_count - 1)];
+	{
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		queue->jobs.push_back(job);
+	}
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		pending++;
+	}
+	wake.notify_one();
+}
+
+int JobSystem::get_thread_count() {
+	return thread_count;
+}
+
+bool JobSystem::run_one(int index) {
+	Job job;
+	bool found = false;
+
+	//Own queue, newest first
+	{
+		Queue *queue = queues[index];
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		if (!queue->jobs.empty()) {
+			job = queue->jobs.back();
+			queue->jobs.pop_back();
+			found = true;
+		}
+	}
+
+	//Steal the oldest job of another queue
+	for (int i = 1; i < thread_count && !found; i++) {
+		Queue *queue = queues[(index + i) % thread_count];
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		if (!queue->jobs.empty() && (index != 0 || queue->jobs.front().task == nullptr)) {
+			job = queue->jobs.front();
+			queue->jobs.pop_front();
+			found = true;
+		}
+	}
+
+	if (!found)
+		return false;
+
+	pending--;
+	if (job.task != nullptr) {
+		(*job.task)();
+		delete job.task;
+		return true;
+	}
+	(*job.fn)(job.begin, job.end);
+	job.remaining->fetch_sub(1);
+	return true;
+}
+
+void JobSystem::worker_loop(int index) {
+	worker_pool = this;
+	worker_index = index;
+
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(sleep_mutex);
+			wake.wait(lock, [this] {return quit || pending.load() > 0;});
+		}
+
+		//Drains the async jobs before quitting
+		while (run_one(index));
+		if (quit && pending.load() <= 0)
+			return;
+	}
+}
@@ -0,0 +1,69 @@
+#ifndef JOBS_HPP
+#define JOBS_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using RangeFnT = std::function<void(int, int)>;
+using TaskFnT = std::function<void()>;
+
+/*
+Work-stealing thread pool.
+Each thread owns a deque: it pops its own jobs from the back and steals from the front of the others.
+The thread calling `parallel_for()` works too, so a pool of 1 runs everything inline.
+*/
+class JobSystem {
+public:
+	JobSystem(int thread_count=0); //0: one per core
+	~JobSystem();
+
+	/*
+	Runs `fn(begin, end)` over [0, count) in chunks of `grain` and waits for all of them.
+	The chunks only depend on `count` and `grain`, never on the thread count,
+	so per-chunk results (and reductions over them in chunk order) are the same for any pool.
+	*/
+	void parallel_for(int count, int grain, const RangeFnT &fn);
+
+	/*
+	Starts `fn` on a worker and returns at once; the caller tracks its completion.
+	Threads outside the pool never pick these up while helping a `parallel_for()`, so they don't stall on them.
+	A pool of 1 has no workers: `fn` runs inline.
+	The destructor runs the ones still queued.
+	*/
+	void run_async(const TaskFnT &fn);
+
+	int get_thread_count();
+
+private:
+	struct Job {
+		const RangeFnT *fn;
+		int begin, end;
+		std::atomic<int> *remaining;
+		TaskFnT *task; //Owned; instead of `fn` for `run_async()`
+	};
+
+	struct Queue {
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	void worker_loop(int index);
+	bool run_one(int index); //Own job or a stolen one; false if there was none. Index 0 leaves the async jobs alone.
+
+	int thread_count;
+	std::vector<Queue *> queues; //[0] is for the threads outside the pool; never gets async jobs
+	std::atomic<int> next_async; //Round-robin over the workers' queues
+	std::vector<std::thread> threads;
+
+	std::mutex sleep_mutex;
+	std::condition_variable wake;
+	std::atomic<int> pending;
+	bool quit;
+};
+
+#endif
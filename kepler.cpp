@@ -0,0 +1,265 @@
+#include "kepler.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+
+#include "utils.hpp"
+
+const int WARM_ITERATIONS = 2;
+const int COLD_ITERATIONS = 8;
+const float MAX_WARM_STEP = 0.5f; //Radians of mean anomaly; further jumps start cold
+
+//Wraps to [-pi, pi]. Rounds by adding 1.5 * 2^23 instead of `std::floor()`, which doesn't vectorize under the default math flags.
+static inline float wrap_angle(float x) {
+	const float ROUNDER = 12582912.0f;
+	float turns = (x * (1 / (2*PI)) + ROUNDER) - ROUNDER;
+	return x - 2*PI * turns;
+}
+
+/*
+sin/cos for [-pi, pi], with polynomials only so loops using it vectorize.
+Taylor series on the half angle ([-pi/2, pi/2]), then the double angle formulas.
+*/
+static inline void fast_sincos(float x, float *s, float *c) {
+	float h = x * 0.5f;
+	float h2 = h * h;
+	float sh = h * (1 + h2 * (-1.0f/6 + h2 * (1.0f/120 + h2 * (-1.0f/5040 + h2 * (1.0f/362880 + h2 * (-1.0f/39916800))))));
+	float ch = 1 + h2 * (-1.0f/2 + h2 * (1.0f/24 + h2 * (-1.0f/720 + h2 * (1.0f/40320 + h2 * (-1.0f/3628800 + h2 * (1.0f/479001600))))));
+	*s = 2 * sh * ch;
+	*c = ch * ch - sh * sh;
+}
+
+OrbitBasis get_orbit_basis(const OrbitalElements &el) {
+	float cn = std::cos(el.ascending_node), sn = std::sin(el.ascending_node);
+	float cw = std::cos(el.argument_of_periapsis), sw = std::sin(el.argument_of_periapsis);
+	float ci = std::cos(el.inclination), si = std::sin(el.inclination);
+
+	//Usual (x, y, z) with z up, mapped to (X, Z, Y)
+	OrbitBasis basis;
+	basis.p = glm::vec3(cn*cw - sn*sw*ci, sw*si, sn*cw + cn*sw*ci);
+	basis.q = glm::vec3(-cn*sw - sn*cw*ci, cw*si, -sn*sw + cn*cw*ci);
+	return basis;
+}
+
+OrbitalElements circular_orbit(float radius, float freq) {
+	OrbitalElements elements = {};
+	elements.semi_major_axis = radius;
+	elements.mean_motion = freq * 2*PI;
+	return elements;
+}
+
+glm::vec3 propagate_orbit(const OrbitalElements &el, float time) {
+	glm::vec3 position, velocity;
+	propagate_orbit(el, time, &position, &velocity);
+	return position;
+}
+
+void propagate_orbit(const OrbitalElements &el, float time, glm::vec3 *position, glm::vec3 *velocity) {
+	propagate_orbit(el, get_orbit_basis(el), time, position, velocity);
+}
+
+void propagate_orbit(const OrbitalElements &el, const OrbitBasis &basis, float time, glm::vec3 *position, glm::vec3 *velocity) {
+	float e = el.eccentricity;
+	float m = wrap_angle(el.mean_anomaly + el.mean_motion * time);
+
+	float ecc_anomaly = m + e * std::sin(m);
+	for (int i = 0; i < COLD_ITERATIONS && e > 0; i++) {
+		float delta = (ecc_anomaly - e * std::sin(ecc_anomaly) - m) / (1 - e * std::cos(ecc_anomaly));
+		ecc_anomaly -= delta;
+		if (std::fabs(delta) < 1e-7f)
+			break;
+	}
+
+	glm::vec3 p = basis.p, q = basis.q;
+	float a = el.semi_major_axis, b = a * std::sqrt(1 - e*e);
+	float s = std::sin(ecc_anomaly), c = std::cos(ecc_anomaly);
+	float ecc_anomaly_rate = el.mean_motion / (1 - e * c); //dE/dt
+
+	*position = p * (a * (c - e)) + q * (b * s);
+	*velocity = (p * (-a * s) + q * (b * c)) * ecc_anomaly_rate;
+}
+
+void propagate_orbit(const OrbitalElements &el, const OrbitBasis &basis, double time, glm::dvec3 *position, glm::dvec3 *velocity) {
+	double e = el.eccentricity;
+	double m = std::remainder(el.mean_anomaly + el.mean_motion * time, 2*PI_D);
+
+	double ecc_anomaly = m + e * std::sin(m);
+	for (int i = 0; i < COLD_ITERATIONS && e > 0; i++) {
+		double delta = (ecc_anomaly - e * std::sin(ecc_anomaly) - m) / (1 - e * std::cos(ecc_anomaly));
+		ecc_anomaly -= delta;
+		if (std::fabs(delta) < 1e-15)
+			break;
+	}
+
+	glm::dvec3 p = basis.p, q = basis.q;
+	double a = el.semi_major_axis, b = a * std::sqrt(1 - e*e);
+	double s = std::sin(ecc_anomaly), c = std::cos(ecc_anomaly);
+	double ecc_anomaly_rate = el.mean_motion / (1 - e * c);
+
+	*position = p * (a * (c - e)) + q * (b * s);
+	*velocity = (p * (-a * s) + q * (b * c)) * ecc_anomaly_rate;
+}
+
+bool get_orbital_elements(glm::vec3 position, glm::vec3 velocity, float gm, float time, OrbitalElements *el) {
+	//To the usual (x, y, z) with z up; see `get_orbit_basis()`
+	glm::dvec3 r(position.x, position.z, position.y);
+	glm::dvec3 v(velocity.x, velocity.z, velocity.y);
+	double mu = gm;
+
+	double dist = glm::length(r);
+	double energy = glm::dot(v, v) / 2 - mu / dist;
+	glm::dvec3 h = glm::cross(r, v);
+	if (energy >= 0.0 || glm::length(h) <= 0.0)
+		return false; //Unbound or radial
+
+	glm::dvec3 ecc = glm::cross(v, h) / mu - r / dist;
+	double e = glm::length(ecc);
+	if (e >= 1.0)
+		return false;
+
+	//Orbit frame: w normal, p towards the periapsis (along r for circular orbits), q = w x p
+	glm::dvec3 w = glm::normalize(h);
+	glm::dvec3 p = (e > 1e-6) ? ecc / e : r / dist;
+	glm::dvec3 q = glm::cross(w, p);
+
+	//w = (sin N sin i, -cos N sin i, cos i)
+	double inclination = std::acos(glm::clamp(w.z, -1.0, 1.0));
+	double node = (std::sin(inclination) > 1e-6) ? std::atan2(w.x, -w.y) : 0.0;
+
+	//p, rotated back by the node = (cos w, sin w cos i, sin w sin i)
+	double cn = std::cos(node), sn = std::sin(node);
+	glm::dvec3 p_node(cn*p.x + sn*p.y, -sn*p.x + cn*p.y, p.z);
+	double periapsis = std::atan2(p_node.y * std::cos(inclination) + p_node.z * std::sin(inclination), p_node.x);
+
+	double a = 1.0 / (2.0 / dist - glm::dot(v, v) / mu);
+	double true_anomaly = std::atan2(glm::dot(r, q), glm::dot(r, p));
+	double ecc_anomaly = std::atan2(std::sqrt(1 - e*e) * std::sin(true_anomaly), e + std::cos(true_anomaly));
+	double mean_motion = std::sqrt(mu / (a*a*a));
+	double mean_anomaly = ecc_anomaly - e * std::sin(ecc_anomaly) - mean_motion * time;
+
+	el->semi_major_axis = (float) a;
+	el->eccentricity = (float) e;
+	el->inclination = (float) inclination;
+	el->ascending_node = (float) node;
+	el->argument_of_periapsis = (float) periapsis;
+	el->mean_anomaly = (float) std::remainder(mean_anomaly, 2 * 3.14159265358979323846);
+	el->mean_motion = (float) mean_motion;
+	return true;
+}
+
+KeplerBatch::KeplerBatch() {
+	count = 0;
+	solved = false;
+	last_time = 0.0f;
+}
+
+int KeplerBatch::add(const OrbitalElements &el) {
+	OrbitBasis basis = get_orbit_basis(el);
+	glm::vec3 p = basis.p, q = basis.q;
+	float a = el.semi_major_axis, b = a * std::sqrt(1 - el.eccentricity * el.eccentricity);
+
+	mean_anomaly.push_back(el.mean_anomaly);
+	mean_motion.push_back(el.mean_motion);
+	eccentricity.push_back(el.eccentricity);
+	px.push_back(p.x * a); py.push_back(p.y * a); pz.push_back(p.z * a);
+	qx.push_back(q.x * b); qy.push_back(q.y * b); qz.push_back(q.z * b);
+	offset.push_back(0.0f);
+	slope.push_back(0.0f);
+	x.push_back(0.0f); y.push_back(0.0f); z.push_back(0.0f);
+
+	solved = false;
+	return count++;
+}
+
+int KeplerBatch::get_count() {
+	return count;
+}
+
+/*
+Kepler's equation E - e sin E = M for [0, n), positions into x/y/z.
+The iteration count is fixed at compile time so that the loop vectorizes.
+E - M is periodic in M, so it carries over the wrap of M:
+	warm start: last E - M, plus its first order change (dE/dM - 1 = e cos E / (1 - e cos E))
+	cold start: M + e sin M
+*/
+template <bool WARM, int ITERATIONS>
+static void solve(
+	int n, float time, float delta_time,
+	const float *__restrict m0, const float *__restrict mean_motion, const float *__restrict eccentricity,
+	const float *__restrict px, const float *__restrict py, const float *__restrict pz,
+	const float *__restrict qx, const float *__restrict qy, const float *__restrict qz,
+	float *__restrict offset, float *__restrict slope,
+	float *__restrict x, float *__restrict y, float *__restrict z
+) {
+	for (int i = 0; i < n; i++) {
+		float e = eccentricity[i];
+		float m = wrap_angle(m0[i] + mean_motion[i] * time);
+
+		float s, c;
+		float ecc_anomaly;
+		if (WARM)
+			ecc_anomaly = m + offset[i] + mean_motion[i] * delta_time * slope[i] / (1 - slope[i]);
+		else {
+			fast_sincos(m, &s, &c);
+			ecc_anomaly = m + e * s;
+		}
+
+		for (int k = 0; k < ITERATIONS; k++) {
+			fast_sincos(wrap_angle(ecc_anomaly), &s, &c);
+			ecc_anomaly -= (ecc_anomaly - e * s - m) / (1 - e * c);
+		}
+
+		fast_sincos(wrap_angle(ecc_anomaly), &s, &c);
+		offset[i] = ecc_anomaly - m;
+		slope[i] = e * c;
+
+		float u = c - e;
+		x[i] = px[i] * u + qx[i] * s;
+		y[i] = py[i] * u + qy[i] * s;
+		z[i] = pz[i] * u + qz[i] * s;
+	}
+}
+
+void KeplerBatch::update(float time) {
+	float delta_time = time - last_time;
+
+	//Warm only if every orbit moved little since the last solve
+	bool warm = solved;
+	for (int i = 0; i < count && warm; i++)
+		warm = std::abs(mean_motion[i] * delta_time) < MAX_WARM_STEP;
+
+	if (warm)
+		solve<true, WARM_ITERATIONS>(
+			count, time, delta_time,
+			mean_anomaly.data(), mean_motion.data(), eccentricity.data(),
+			px.data(), py.data(), pz.data(), qx.data(), qy.data(), qz.data(),
+			offset.data(), slope.data(), x.data(), y.data(), z.data()
+		);
+	else
+		solve<false, COLD_ITERATIONS>(
+			count, time, delta_time,
+			mean_anomaly.data(), mean_motion.data(), eccentricity.data(),
+			px.data(), py.data(), pz.data(), qx.data(), qy.data(), qz.data(),
+			offset.data(), slope.data(), x.data(), y.data(), z.data()
+		);
+
+	solved = true;
+	last_time = time;
+}
+
+glm::vec3 KeplerBatch::get_position(int i) {
+	return glm::vec3(x[i], y[i], z[i]);
+}
+
+const float *KeplerBatch::get_x() {
+	return x.data();
+}
+
+const float *KeplerBatch::get_y() {
+	return y.data();
+}
+
+const float *KeplerBatch::get_z() {
+	return z.data();
+}
@@ -0,0 +1,70 @@
+#ifndef KEPLER_HPP
+#define KEPLER_HPP
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/*
+On-rails orbit. Angles in radians.
+The reference plane is XZ with Y up; with no inclination, node or periapsis argument, the periapsis is on +X and the body moves towards +Z.
+*/
+struct OrbitalElements {
+	float semi_major_axis;
+	float eccentricity; //[0, 1)
+	float inclination;
+	float ascending_node; //Longitude of
+	float argument_of_periapsis;
+	float mean_anomaly; //At time 0
+	float mean_motion; //Radians per second
+};
+
+//Orientation of an orbit: towards the periapsis and 90 degrees ahead. Worth keeping for orbits propagated often.
+struct OrbitBasis {
+	glm::vec3 p;
+	glm::vec3 q;
+};
+
+OrbitalElements circular_orbit(float radius, float freq); //`freq`: orbits per second
+OrbitBasis get_orbit_basis(const OrbitalElements &elements);
+glm::vec3 propagate_orbit(const OrbitalElements &elements, float time); //Position relative to the focus
+void propagate_orbit(const OrbitalElements &elements, float time, glm::vec3 *position, glm::vec3 *velocity);
+void propagate_orbit(const OrbitalElements &elements, const OrbitBasis &basis, float time, glm::vec3 *position, glm::vec3 *velocity);
+void propagate_orbit(const OrbitalElements &elements, const OrbitBasis &basis, double time, glm::dvec3 *position, glm::dvec3 *velocity); //In double, for absolute positions
+
+//Elements of the orbit through `position`/`velocity` (relative to the focus) at `time`. false if it isn't an ellipse.
+bool get_orbital_elements(glm::vec3 position, glm::vec3 velocity, float gm, float time, OrbitalElements *elements);
+
+/*
+Many on-rails orbits as structure-of-arrays.
+`update()` solves Kepler's equation for all of them with a fixed number of Newton steps, warm-started from the last solve,
+so the loop has no branches and vectorizes.
+*/
+class KeplerBatch {
+public:
+	KeplerBatch();
+
+	int add(const OrbitalElements &elements); //Returns the index
+	int get_count();
+
+	void update(float time);
+
+	glm::vec3 get_position(int i); //As of the last `update()`
+	const float *get_x();
+	const float *get_y();
+	const float *get_z();
+
+private:
+	int count;
+	bool solved;
+	float last_time;
+
+	std::vector<float> mean_anomaly, mean_motion, eccentricity;
+	std::vector<float> px, py, pz; //Towards the periapsis, scaled by a
+	std::vector<float> qx, qy, qz; //90 degrees ahead, scaled by b
+	std::vector<float> offset, slope; //E - M and e cos E of the last solve, for the warm start
+
+	std::vector<float> x, y, z;
+};
+
+#endif
@@ -0,0 +1,174 @@
+#include "landing.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#include "utils.hpp"
+
+LandingScore score_landing(glm::vec3 velocity, glm::vec3 to_planet) {
+	LandingScore score;
+	score.speed = glm::length(velocity);
+	score.angle = glm::degrees(glm::acos(glm::clamp(
+		glm::dot(glm::normalize(velocity), glm::normalize(to_planet)), -1.0f, 1.0f)));
+
+	score.speed_score = -2 * score.speed + 110;
+	if (score.speed_score > 100) score.speed_score = 100;
+	if (score.speed_score < 0) score.speed_score = 0;
+
+	score.angle_score = (-5.0f/18) * score.angle + 100;
+
+	score.total = (score.speed_score * SPEED_SCORE_WEIGHT + score.angle_score * ANGLE_SCORE_WEIGHT)
+		/ (SPEED_SCORE_WEIGHT + ANGLE_SCORE_WEIGHT);
+	return score;
+}
+
+const int MAX_SUBDIVISIONS = 20; //Contact times within 2^-20 of the step
+
+//Bezier control points of the Hermite curve of a step. Relative to the body, so float is enough.
+static void get_step_curve(const BodyState &start, const BodyState &end, float dt, glm::vec3 c[4]) {
+	double h = dt;
+	c[0] = glm::vec3(start.position);
+	c[1] = glm::vec3(start.position + start.velocity * (h / 3));
+	c[2] = glm::vec3(end.position - end.velocity * (h / 3));
+	c[3] = glm::vec3(end.position);
+}
+
+//Bounding sphere of the control points; the curve stays in their hull
+static void get_bounds(const glm::vec3 c[4], glm::vec3 *center, float *extent) {
+	*center = (c[0] + c[1] + c[2] + c[3]) * 0.25f;
+	float extent2 = 0.0f;
+	for (int i = 0; i < 4; i++)
+		extent2 = glm::max(extent2, glm::dot(c[i] - *center, c[i] - *center));
+	*extent = std::sqrt(extent2);
+}
+
+//The curve misses the sphere if the bounds do
+static bool is_clear(const glm::vec3 c[4], float radius) {
+	glm::vec3 center;
+	float extent;
+	get_bounds(c, &center, &extent);
+	return glm::length(center) - extent > radius;
+}
+
+static void split_curve(const glm::vec3 c[4], glm::vec3 left[4], glm::vec3 right[4]) {
+	//de Casteljau at the middle
+	glm::vec3 ab = (c[0] + c[1]) * 0.5f, bc = (c[1] + c[2]) * 0.5f, cd = (c[2] + c[3]) * 0.5f;
+	glm::vec3 abc = (ab + bc) * 0.5f, bcd = (bc + cd) * 0.5f;
+	glm::vec3 mid = (abc + bcd) * 0.5f;
+	left[0] = c[0]; left[1] = ab; left[2] = abc; left[3] = mid;
+	right[0] = mid; right[1] = bcd; right[2] = cd; right[3] = c[3];
+}
+
+static glm::vec3 get_curve_point(const glm::vec3 c[4], float t) {
+	float u = 1 - t;
+	return c[0] * (u*u*u) + c[1] * (3*u*u*t) + c[2] * (3*u*t*t) + c[3] * (t*t*t);
+}
+
+//First contact on the piece of the curve over [s0, s1]; the halves that are clear are skipped
+static float find_contact(const glm::vec3 c[4], float s0, float s1, float radius, int depth) {
+	if (glm::dot(c[0], c[0]) <= radius * radius)
+		return s0;
+	if (is_clear(c, radius))
+		return -1.0f;
+	if (depth == MAX_SUBDIVISIONS)
+		return s0; //Grazing, closer than the subdivision can tell
+
+	glm::vec3 left[4], right[4];
+	split_curve(c, left, right);
+
+	float s_mid = (s0 + s1) * 0.5f;
+	float s = find_contact(left, s0, s_mid, radius, depth + 1);
+	if (s >= 0.0f)
+		return s;
+	return find_contact(right, s_mid, s1, radius, depth + 1);
+}
+
+float get_time_of_impact(const BodyState &start, const BodyState &end, float dt, float radius) {
+	glm::vec3 c[4];
+	get_step_curve(start, end, dt, c);
+	return find_contact(c, 0.0f, 1.0f, radius, 0);
+}
+
+const int SURFACE_BISECTIONS = 16;
+const int MAX_SURFACE_SAMPLES = 4096; //Per piece left wider than a feature by the subdivisions
+
+//`find_contact()` against relief
+static float find_surface_contact(const glm::vec3 c[4], float s0, float s1, Surface *surface, float clearance, int depth) {
+	glm::vec3 center;
+	float extent;
+	get_bounds(c, &center, &extent);
+	float dist = glm::length(center);
+	float angle = (extent < dist) ? std::asin(extent / dist) : PI;
+	if (dist - extent > surface->get_max_radius(center / dist, angle) + clearance)
+		return -1.0f;
+
+	//Down to a feature: bisect between the ends, as the relief can't dip in between.
+	//A piece still wider than a feature when the subdivisions run out (a long warped step) is first
+	//sampled every half feature, so a graze between its ends isn't missed; then bisected between the samples around the contact.
+	float half_feature = surface->get_feature_angle() * 0.5f;
+	bool at_feature = angle < half_feature;
+	if (at_feature || depth == MAX_SUBDIVISIONS) {
+		auto below = [&](float t) {
+			glm::vec3 p = get_curve_point(c, t);
+			return glm::length(p) <= surface->get_radius(p, glm::mix(s0, s1, t)) + clearance;
+		};
+		if (below(0.0f))
+			return s0;
+
+		//`angle` is half the piece's span
+		int samples = at_feature ? 1 : std::min((int) std::ceil(2 * angle / half_feature), MAX_SURFACE_SAMPLES);
+		float lo = 0.0f, hi = -1.0f;
+		for (int i = 1; i <= samples; i++) {
+			float t = (float) i / samples;
+			if (below(t)) {
+				hi = t;
+				break;
+			}
+			lo = t;
+		}
+		if (hi < 0.0f)
+			return -1.0f;
+
+		for (int i = 0; i < SURFACE_BISECTIONS; i++) {
+			float mid = (lo + hi) * 0.5f;
+			if (below(mid))
+				hi = mid;
+			else
+				lo = mid;
+		}
+		return glm::mix(s0, s1, hi);
+	}
+
+	glm::vec3 left[4], right[4];
+	split_curve(c, left, right);
+
+	float s_mid = (s0 + s1) * 0.5f;
+	float s = find_surface_contact(left, s0, s_mid, surface, clearance, depth + 1);
+	if (s >= 0.0f)
+		return s;
+	return find_surface_contact(right, s_mid, s1, surface, clearance, depth + 1);
+}
+
+float get_time_of_impact(const BodyState &start, const BodyState &end, float dt, Surface *surface, float clearance) {
+	glm::vec3 c[4];
+	get_step_curve(start, end, dt, c);
+	if (is_clear(c, surface->get_max_radius() + clearance))
+		return -1.0f;
+	return find_surface_contact(c, 0.0f, 1.0f, surface, clearance, 0);
+}
+
+BodyState interpolate_step(const BodyState &start, const BodyState &end, float dt, float s_float) {
+	//The curve of `get_step_curve()`, in double as the states
+	double h = dt, s = s_float, t = 1 - s;
+	glm::dvec3 c[4] = {
+		start.position, start.position + start.velocity * (h / 3),
+		end.position - end.velocity * (h / 3), end.position
+	};
+
+	BodyState state;
+	state.position = c[0] * (t*t*t) + c[1] * (3*t*t*s) + c[2] * (3*t*s*s) + c[3] * (s*s*s);
+	state.velocity = ((c[1] - c[0]) * (t*t) + (c[2] - c[1]) * (2*t*s) + (c[3] - c[2]) * (s*s)) * (3 / h);
+	return state;
+}
@@ -0,0 +1,52 @@
+#ifndef LANDING_HPP
+#define LANDING_HPP
+
+#include <glm/glm.hpp>
+
+#include "integrator.hpp"
+
+const float LANDING_ALTITUDE = 0.1f; //Touchdown, above the surface. Twice the camera's near plane, so it never clips into the planet.
+const float SPEED_SCORE_WEIGHT = 3.0f;
+const float ANGLE_SCORE_WEIGHT = 1.0f;
+
+struct LandingScore {
+	float speed; //At touchdown
+	float angle; //Degrees between the velocity and the direction to the planet
+	float speed_score;
+	float angle_score;
+	float total; //Weighted
+};
+
+/*
+Scores a touchdown with `velocity`, `to_planet` being the direction to the planet's center.
+Speed: `100` on 5, `0` on 55
+Angle: `100` on 0, `0` on 360.
+*/
+LandingScore score_landing(glm::vec3 velocity, glm::vec3 to_planet);
+
+/*
+Continuous collision of a step against a sphere around the origin.
+`start` and `end` are the ship relative to the sphere's center, `dt` apart. The path between them is the cubic Hermite curve
+through both states, as accurate as the integrators, and its first contact is found by subdividing it.
+Returns the fraction of the step in [0, 1] of the first contact, or -1 if the step stays clear.
+*/
+float get_time_of_impact(const BodyState &start, const BodyState &end, float dt, float radius);
+BodyState interpolate_step(const BodyState &start, const BodyState &end, float dt, float s); //At fraction `s`, along the same curve
+
+//A body's surface around the origin over a step, for the sweep against relief
+class Surface {
+public:
+	virtual float get_max_radius() = 0; //Anywhere
+	virtual float get_max_radius(glm::vec3 direction, float angle) = 0; //Over the cap of `angle` radians around `direction`, during the whole step
+	virtual float get_radius(glm::vec3 position, float s) = 0; //Under `position`, at fraction `s` of the step
+	virtual float get_feature_angle() = 0; //Smallest relief feature, radians
+};
+
+/*
+`get_time_of_impact()` against `surface`, lifted by `clearance`.
+Pieces of the curve are skipped while their hull stays above the highest relief under it;
+the ones down to a feature in size are bisected on the exact surface.
+*/
+float get_time_of_impact(const BodyState &start, const BodyState &end, float dt, Surface *surface, float clearance);
+
+#endif
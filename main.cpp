@@ -6,22 +6,38 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/string_cast.hpp>
 
+#include <learnopengl/gl_state.h>
 #include <learnopengl/shader_m.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
 
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+#include "chunked_terrain.hpp"
+#include "culling.hpp"
+#include "evaluate.hpp"
+#include "frame.hpp"
+#include "jobs.hpp"
+#include "landing.hpp"
+#include "terrain.hpp"
 #include "planet.hpp"
 #include "player.hpp"
+#include "render_queue.hpp"
+#include "replay.hpp"
+#include "simulation.hpp"
+#include "trajectory.hpp"
 #include "utils.hpp"
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 //void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void process_input(GLFWwindow *window);
 //unsigned int loadTexture(const char *path);
 unsigned int load_cubemap(vector<std::string> faces);
@@ -44,6 +60,13 @@ float last_frame = 0.0f;
 
 bool landed = false;
 
+//Inputs of the current frame, for the recording
+FrameInput frame_input;
+
+//Time warp
+float warp = 1.0f;
+const float MAX_WARP = 100000.0f;
+
 //To bypass the stbi error (Should be included in only one translation unit)
 class DrawableModel : public Drawable {
 public:
@@ -53,7 +76,50 @@ private:
 	Model *model;
 };
 
-int main() {
+int main(int argc, char *argv[]) {
+	//Options
+	IntegratorType integrator_type = IntegratorType::VELOCITY_VERLET;
+	float physics_hz = 240.0f;
+	const char *record_path = nullptr;
+	int evaluation_runs = 0;
+	unsigned int seed = 1;
+	int thread_count = 0;
+	for (int i = 1; i < argc; i++) {
+		if (std::strncmp(argv[i], "--integrator=", 13) == 0) {
+			if (!parse_integrator_type(argv[i] + 13, &integrator_type)) {
+				std::cout << "Unknown integrator: " << argv[i] + 13
+					<< " (semi-implicit-euler, velocity-verlet, rk4, forest-ruth)" << std::endl;
+				return -1;
+			}
+		}
+		else if (std::strncmp(argv[i], "--hz=", 5) == 0) {
+			char *end;
+			physics_hz = std::strtof(argv[i] + 5, &end);
+			if (*end != '\0' || !std::isfinite(physics_hz) || physics_hz <= 0.0f) {
+				std::cout << "Invalid physics rate: " << argv[i] + 5 << " (a positive number of Hz)" << std::endl;
+				return -1;
+			}
+		}
+		else if (std::strncmp(argv[i], "--record=", 9) == 0)
+			record_path = argv[i] + 9;
+		else if (std::strncmp(argv[i], "--replay=", 9) == 0)
+			return run_replay(argv[i] + 9); //Headless
+		else if (std::strncmp(argv[i], "--evaluate=", 11) == 0)
+			evaluation_runs = std::atoi(argv[i] + 11);
+		else if (std::strncmp(argv[i], "--seed=", 7) == 0)
+			seed = (unsigned int) std::strtoul(argv[i] + 7, nullptr, 10);
+		else if (std::strncmp(argv[i], "--threads=", 10) == 0)
+			thread_count = std::atoi(argv[i] + 10);
+		else {
+			std::cout << "Usage: " << argv[0]
+				<< " [--integrator=<name>] [--hz=<physics rate>] [--record=<file>] [--replay=<file>]"
+				<< " [--evaluate=<runs> [--seed=<n>] [--threads=<n>]]" << std::endl;
+			return -1;
+		}
+	}
+	if (evaluation_runs > 0)
+		return run_evaluation(evaluation_runs, seed, thread_count); //Headless
+
 	// glfw: initialize and configure
 	// ------------------------------
 	glfwInit();
@@ -77,6 +143,7 @@ int main() {
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 	//glfwSetCursorPosCallback(window, mouse_callback);
 	glfwSetScrollCallback(window, scroll_callback);
+	glfwSetKeyCallback(window, key_callback);
 
 	// tell GLFW to capture our mouse
 	//glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -97,8 +164,17 @@ int main() {
 	// -----------------------------
 	glEnable(GL_DEPTH_TEST);
 
-	Shader planet_shader("shaders/planet.vs", "shaders/planet.fs");
-	Model planet_model("resources/mars/mars.obj");
+	//Features of the planet's shader, compiled in only when asked for; their bits are listed in planet.fs
+	ShaderPermutations planet_shaders("shaders/planet.vs", "shaders/planet.fs", {"SPOT_LIGHT", "SPECULAR_MAP"});
+	//The model has one texture, and the headlamp (5% diffuse, no specular) is lost in the sunlight: neither is worth a fragment's time
+	const unsigned int PLANET_FEATURES = 0;
+	Shader &planet_shader = *planet_shaders.get(PLANET_FEATURES);
+	//The material never changes; the camera and the lights come from `frame_uniforms`
+	planet_shader.use();
+	planet_shader.setInt("material.diffuse", 0);
+	planet_shader.setInt("material.specular", 0);
+	planet_shader.setFloat("material.shininess", 1.0f);
+	Model planet_model(MARS_MESH_PATH);
 	DrawableModel planet_drawable_model(&planet_model);
 
 	Planet planet(
@@ -107,38 +183,26 @@ int main() {
 		0.01f, //orbit_freq
 		100.0f, //orbit_radius
 		0.05f, //rot_freq
-		glm::vec3(0.0f, 1.0f, 0.0f), //rot_axis
-		
-		[](Shader *shader, Planet *planet) {
-			shader->setInt("material.diffuse", 0);
-			shader->setInt("material.specular", 0);
-			shader->setFloat("material.shininess", 1.0f);
-
-			shader->setVec3("viewPos", camera.Position);
-
-			shader->setVec3("dirLight.direction", planet->get_position());
-			shader->setVec3("dirLight.ambient", glm::vec3(0.2f));
-			shader->setVec3("dirLight.diffuse", glm::vec3(1.0f));
-			shader->setVec3("dirLight.specular", glm::vec3(0.1f));
-
-			shader->setVec3("spotLight.position", camera.Position);
-			shader->setVec3("spotLight.direction", camera.Front);
-			shader->setVec3("spotLight.ambient", glm::vec3(0.0f));
-			shader->setVec3("spotLight.diffuse", glm::vec3(0.05f));
-			shader->setVec3("spotLight.specular", glm::vec3(0.0f));
-			shader->setFloat("spotLight.constant", 1.0f);
-			shader->setFloat("spotLight.linear", 0.045f);
-			shader->setFloat("spotLight.quadratic", 0.0075f);
-			shader->setFloat("spotLight.cutOff", glm::cos(glm::radians(15.0f)));
-			shader->setFloat("spotLight.outerCutOff", glm::cos(glm::radians(17.5f)));
-		}
+		glm::vec3(0.0f, 1.0f, 0.0f) //rot_axis
 	);
 
+	//Collide with the relief of the bump map; a plain sphere without it
+	Terrain terrain;
+	terrain.load(MARS_MESH_PATH, MARS_BUMP_PATH);
+	planet.set_terrain(&terrain, MARS_RELIEF);
+
+	//Drawn from the same relief, in chunks whose detail follows the camera
+	JobSystem jobs;
+	ChunkedTerrain *chunks = nullptr;
+	if (terrain.is_loaded()) {
+		chunks = new ChunkedTerrain(&terrain, MARS_RELIEF, &jobs);
+		planet.set_chunked_terrain(chunks);
+	}
+
 	//Init. camera
-	planet.update();
-	glm::vec3 initial_position = planet.get_position() + glm::vec3(0.0f, 1.0f, -2 * planet.get_radius());
-	camera.Position = initial_position;
-	player.set_position(initial_position + glm::vec3(0, 4, 0));
+	planet.update(0.0f);
+	glm::dvec3 initial_position = planet.get_position() + glm::dvec3(0.0, 1.0, -2.0 * planet.get_radius());
+	player.set_position(initial_position + glm::dvec3(0, 4, 0));
 	player.get_camera_vecs(&camera.Front, &camera.Right, &camera.Up);
 
 	//Set cubemap texture
@@ -152,18 +216,40 @@ int main() {
     };
     unsigned int cubemap_texture = load_cubemap(faces);
 
+	FrameUniforms *frame_uniforms = new FrameUniforms();
+	Culler culler;
+	RenderQueue render_queue;
+
+	Simulation simulation(&planet, &player, integrator_type, 1.0f / physics_hz);
+	TrajectoryPredictor predictor(&planet, integrator_type, 1.0f / physics_hz);
+
+	ReplayRecorder *recorder = nullptr;
+	if (record_path != nullptr)
+		recorder = new ReplayRecorder(record_path, make_replay_header(&simulation, &planet, &player));
+	last_frame = get_time();
+
 	// render loop
 	// -----------
 	while (!glfwWindowShouldClose(window)) {
 		// per-frame time logic
 		// --------------------
-		float current_frame = static_cast<float>(glfwGetTime());
+		float current_frame = get_time();
 		delta_time = current_frame - last_frame;
 		last_frame = current_frame;
 
+		//Uniform lookups by name of the last frame; 0 once every shader has resolved its handles
+		unsigned int uniform_lookups = Shader::getLookupCount();
+		Shader::resetLookupCount();
+		//Binds of programs, VAOs and textures of the last frame: issued to GL, and skipped as already bound
+		unsigned int binds_issued = GLState::getIssuedCount();
+		unsigned int binds_skipped = GLState::getSkippedCount();
+		GLState::resetCounts();
+
 		// input
 		// -----
 		process_input(window);
+		if (frame_input.reset)
+			simulation.clear_contact();
 
 		// render
 		// ------
@@ -171,9 +257,18 @@ int main() {
 		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		glm::vec3 gravity = planet.get_gravity(player.get_position(), delta_time);
-		player.add_gravity(gravity);
-		camera.Position = player.get_position();
+		simulation.set_warp(warp);
+		simulation.advance(delta_time);
+		if (recorder != nullptr) {
+			frame_input.frame_time = delta_time;
+			frame_input.warp = warp;
+			recorder->record(frame_input);
+		}
+		predictor.update(player.get_state(), simulation.get_ticks(), simulation.get_time());
+		//Everything is drawn relative to the camera, which stays at the origin: the differences are taken in double on the CPU,
+		//so the GPU only sees small floats however far the ship is from the world's origin
+		glm::dvec3 camera_position = player.get_render_position();
+		camera.Position = glm::vec3(0.0f);
 		player.get_camera_vecs(&camera.Front, &camera.Right, &camera.Up);
 
 		const float NEAR = 0.05f;
@@ -181,51 +276,65 @@ int main() {
 		glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float) SCR_WIDTH / SCR_HEIGHT, NEAR, FAR);
 		glm::mat4 view = camera.GetViewMatrix();	
 
-		planet.update();
-		planet.draw(projection, view);
-		player.draw_lines(projection, view, planet.get_position());
-
-		draw_cubemap(projection, view, cubemap_texture);
+		//Everything shared by the frame's draws, in one upload
+		CameraBlock camera_block = {};
+		camera_block.projection = projection;
+		camera_block.view = view;
+		camera_block.view_pos = camera.Position;
+
+		LightsBlock lights_block = {};
+		lights_block.dir_light.direction = glm::vec3(planet.get_position());
+		lights_block.dir_light.ambient = glm::vec3(0.2f);
+		lights_block.dir_light.diffuse = glm::vec3(1.0f);
+		lights_block.dir_light.specular = glm::vec3(0.1f);
+
+		lights_block.spot_light.position = camera.Position;
+		lights_block.spot_light.direction = camera.Front;
+		lights_block.spot_light.ambient = glm::vec3(0.0f);
+		lights_block.spot_light.diffuse = glm::vec3(0.05f);
+		lights_block.spot_light.specular = glm::vec3(0.0f);
+		lights_block.spot_light.constant = 1.0f;
+		lights_block.spot_light.linear = 0.045f;
+		lights_block.spot_light.quadratic = 0.0075f;
+		lights_block.spot_light.cut_off = glm::cos(glm::radians(15.0f));
+		lights_block.spot_light.outer_cut_off = glm::cos(glm::radians(17.5f));
+
+		frame_uniforms->update(camera_block, lights_block);
+		culler.begin_frame(projection * view);
+
+		float pixels_per_radian = SCR_HEIGHT / (2 * glm::tan(glm::radians(camera.Zoom) / 2));
+		planet.draw(camera_position, pixels_per_radian, &culler, &render_queue);
+		player.draw_lines(camera_position, planet.get_position());
+		draw_polyline(predictor.get_path(camera_position), predictor.get_path_length(), glm::vec4(0, 1, 1, 1)); //cyan
+		flush_shapes(pixels_per_radian, &culler, &render_queue);
+		draw_cubemap(cubemap_texture, &render_queue);
+
+		//Every draw of the frame, sorted
+		render_queue.submit();
 
 		//Calculate the distance
 		if (!landed) {
-			glm::vec3 player_to_planet = planet.get_position() - player.get_position();
-			glm::vec3 land_velocity = player.get_velocity();
+			if (!simulation.has_contact()) {
+				glm::vec3 player_to_planet(planet.get_position() - player.get_render_position());
+				float dist = glm::length(player_to_planet) - planet.get_surface_radius(-player_to_planet, simulation.get_render_time());
+				LandingScore score = score_landing(glm::vec3(player.get_velocity()), player_to_planet);
 
-			float dist = glm::length(player_to_planet) - planet.get_radius();
-			float speed = glm::length(land_velocity);
-
-			//Angle between the player's velocity and the direction beween the player and the planet. Degrees.
-			float angle = glm::degrees(glm::acos(
-				glm::dot(glm::normalize(land_velocity), glm::normalize(player_to_planet))));
-
-			//Print
-			if (dist > NEAR*2)
 				//std::cout << '\r' << "Distance: " << dist << ", Speed: " << speed << ", Angle: " << angle;
-				printf("\rDistance: %.2f, Speed: %.4f, Angle: %.2f", dist, speed, angle);
+				printf("\rDistance: %.2f, Speed: %.2f, Angle: %.2f, Warp: %gx%s, Lookups: %u, Binds: %u/%u skipped, Triangles: %d, Visible: %d/%d planets, %d/%d chunks, %d/%d shapes   ",
+					dist, score.speed, score.angle, warp, simulation.is_coasting() ? " (on rails)" : "", uniform_lookups, binds_skipped, binds_issued + binds_skipped, chunks != nullptr ? chunks->get_triangle_count() : 0,
+					culler.get_visible(CULL_PLANETS), culler.get_total(CULL_PLANETS), culler.get_visible(CULL_CHUNKS), culler.get_total(CULL_CHUNKS),
+					culler.get_visible(CULL_SHAPES), culler.get_total(CULL_SHAPES));
+			}
 			else {
 				landed = true; //End
 
-				/*
-				Score using the values on the land
-				Speed: `100` on 0.01, `0` on 0.1
-				Angle: `100` on 0, `0` on 360.
-				*/
-				float speed_score = -1000 * speed + 110;
-				if (speed_score > 100) speed_score = 100;
-				if (speed_score < 0) speed_score = 0;
-
-				float angle_score = (-5.0f/18) * angle + 100;
-
+				//Score using the values at the exact touchdown, which may be inside the last step
+				const Contact &contact = simulation.get_contact();
+				LandingScore score = score_landing(glm::vec3(contact.state.velocity), glm::vec3(contact.planet_position - contact.state.position));
 				putchar('\n');
-				printf("Speed score: %.2f\n", speed_score);
-				printf("Angle score: %.2f\n", angle_score);
-
-				const float speed_score_weight = 3;
-				const float angle_score_weight = 1;
-				float total_score = (speed_score * speed_score_weight + angle_score * angle_score_weight) 
-					/ (speed_score_weight + angle_score_weight);
-				printf("Total score (weights: (%.1f, %.1f)): %.2f\n", speed_score_weight, angle_score_weight, total_score); 
+				printf("Speed score: %.2f\n", score.speed_score);
+				printf("Angle score: %.2f\n", score.angle_score);
+				printf("Total score (weights: (%.1f, %.1f)): %.2f\n", SPEED_SCORE_WEIGHT, ANGLE_SCORE_WEIGHT, score.total); 
 			}
 		}
 
@@ -238,6 +347,13 @@ int main() {
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
 
+	if (recorder != nullptr) {
+		recorder->finish(hash_state(&simulation, &player));
+		delete recorder;
+	}
+
+	delete chunks;
+	delete frame_uniforms;
 	glfwTerminate();
 	utils_cleanup();
 	std::cout << "\nExiting." << std::endl;
@@ -265,11 +381,29 @@ void process_input(GLFWwindow *window) {
 		forward_offset -= delta_time;
 	if (glfwGetKey(window, GLFW_KEY_RIGHT_BRACKET) == GLFW_PRESS)
 		forward_offset += delta_time;
+	if (forward_offset != 0.0f)
+		warp = 1.0f; //No warped thrust
 
-	if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS)
+	frame_input.reset = glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS;
+	if (frame_input.reset)
 		landed = false; //Reset
 
 	player.process_input(forward_offset, pitch_offset, yaw_offset);
+	frame_input.forward_offset = forward_offset;
+	frame_input.pitch_offset = pitch_offset;
+	frame_input.yaw_offset = yaw_offset;
+}
+
+// glfw: key presses, for the ones that act once per press
+// ---------------------------------------------------------
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+	if (action != GLFW_PRESS)
+		return;
+
+	if (key == GLFW_KEY_PERIOD && warp < MAX_WARP)
+		warp *= 10;
+	if (key == GLFW_KEY_COMMA && warp > 1.0f)
+		warp /= 10;
 }
 
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
@@ -326,7 +460,7 @@ unsigned int loadTexture(char const * path) {
 		else if (nrComponents == 4)
 			format = GL_RGBA;
 
-		glBindTexture(GL_TEXTURE_2D, textureID);
+		GLState::bindTexture(GL_TEXTURE_2D, textureID);
 		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
 		glGenerateMipmap(GL_TEXTURE_2D);
 
@@ -358,7 +492,7 @@ unsigned int loadTexture(char const * path) {
 unsigned int load_cubemap(vector<std::string> faces) {
     unsigned int textureID;
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    GLState::bindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 
     int width, height, nrChannels;
     for (unsigned int i = 0; i < faces.size(); i++) {
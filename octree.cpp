@@ -0,0 +1,227 @@
+#include "octree.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+const int MORTON_BITS = 21; //Per axis, 63 in total
+const int GROUP_MORTON_BITS = 10; //Per axis, for ordering the targets
+const int GROUP_SIZE = 32; //Targets sharing an interaction list
+
+//abc -> 00a00b00c
+static unsigned long long spread_bits(unsigned long long v) {
+	v &= 0x1fffff;
+	v = (v | v << 32) & 0x1f00000000ffffULL;
+	v = (v | v << 16) & 0x1f0000ff0000ffULL;
+	v = (v | v << 8) & 0x100f00f00f00f00fULL;
+	v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+	v = (v | v << 2) & 0x1249249249249249ULL;
+	return v;
+}
+
+Octree::Octree(int leaf_size) : leaf_size(leaf_size) {}
+
+void Octree::build(const float *x, const float *y, const float *z, const float *gm, int n) {
+	nodes.clear();
+	if (n == 0)
+		return;
+
+	//Bounding cube
+	glm::vec3 lo(x[0], y[0], z[0]), hi = lo;
+	for (int i = 1; i < n; i++) {
+		lo = glm::min(lo, glm::vec3(x[i], y[i], z[i]));
+		hi = glm::max(hi, glm::vec3(x[i], y[i], z[i]));
+	}
+	glm::vec3 center = (lo + hi) * 0.5f;
+	float half = glm::max(glm::max(hi.x - lo.x, hi.y - lo.y), hi.z - lo.z) * 0.5f * 1.0001f + 1e-6f;
+	glm::vec3 corner = center - glm::vec3(half);
+
+	//Morton order
+	const float cells = (float) (1 << MORTON_BITS);
+	std::vector<std::pair<unsigned long long, int>> keyed(n);
+	for (int i = 0; i < n; i++) {
+		glm::vec3 q = (glm::vec3(x[i], y[i], z[i]) - corner) / (2 * half) * cells;
+		q = glm::clamp(q, glm::vec3(0.0f), glm::vec3(cells - 1));
+		unsigned long long code =
+			spread_bits((unsigned long long) q.x) << 2 |
+			spread_bits((unsigned long long) q.y) << 1 |
+			spread_bits((unsigned long long) q.z);
+		keyed[i] = std::make_pair(code, i);
+	}
+	std::sort(keyed.begin(), keyed.end());
+
+	codes.resize(n);
+	sx.resize(n); sy.resize(n); sz.resize(n); sgm.resize(n);
+	for (int i = 0; i < n; i++) {
+		codes[i] = keyed[i].first;
+		int j = keyed[i].second;
+		sx[i] = x[j]; sy[i] = y[j]; sz[i] = z[j]; sgm[i] = gm[j];
+	}
+
+	build_node(0, n, 0, center, half);
+}
+
+void Octree::build_node(int begin, int end, int level, glm::vec3 center, float half) {
+	int index = (int) nodes.size();
+	nodes.push_back(Node());
+
+	Node node;
+	node.center = center;
+	node.half = half;
+	node.begin = begin;
+	node.count = end - begin;
+	node.leaf = (node.count <= leaf_size || level >= MORTON_BITS);
+
+	//Center of mass
+	double gm = 0.0, cx = 0.0, cy = 0.0, cz = 0.0;
+	for (int i = begin; i < end; i++) {
+		gm += sgm[i];
+		cx += (double) sx[i] * sgm[i];
+		cy += (double) sy[i] * sgm[i];
+		cz += (double) sz[i] * sgm[i];
+	}
+	node.gm = (float) gm;
+	node.com = (gm > 0.0) ? glm::vec3(cx / gm, cy / gm, cz / gm) : center;
+
+	if (!node.leaf) {
+		//Children are the runs of the same octant at this level; the codes are sorted, so they come in order
+		int shift = 3 * (MORTON_BITS - 1 - level);
+		int child_begin = begin;
+		while (child_begin < end) {
+			int octant = (int) (codes[child_begin] >> shift) & 7;
+			int child_end = child_begin + 1;
+			while (child_end < end && (int) ((codes[child_end] >> shift) & 7) == octant)
+				child_end++;
+
+			glm::vec3 offset(
+				(octant & 4) ? half/2 : -half/2,
+				(octant & 2) ? half/2 : -half/2,
+				(octant & 1) ? half/2 : -half/2
+			);
+			build_node(child_begin, child_end, level + 1, center + offset, half/2);
+			child_begin = child_end;
+		}
+	}
+
+	node.skip = (int) nodes.size();
+	nodes[index] = node;
+}
+
+void Octree::collect(glm::vec3 lo, glm::vec3 hi, float theta, std::vector<float> *list) {
+	std::vector<float> &lx = list[0], &ly = list[1], &lz = list[2], &lgm = list[3];
+	lx.clear(); ly.clear(); lz.clear(); lgm.clear();
+
+	float theta2 = theta * theta;
+	int i = 0;
+	int node_count = (int) nodes.size();
+	while (i < node_count) {
+		const Node &node = nodes[i];
+
+		//Closest point of the box to the center of mass
+		glm::vec3 gap = glm::max(glm::vec3(0.0f), glm::max(lo - node.com, node.com - hi));
+		float dist2 = glm::dot(gap, gap);
+		bool outside =
+			glm::any(glm::lessThan(hi, node.center - node.half)) ||
+			glm::any(glm::greaterThan(lo, node.center + node.half));
+		float size = 2 * node.half;
+
+		if (outside && size * size < theta2 * dist2) {
+			lx.push_back(node.com.x); ly.push_back(node.com.y); lz.push_back(node.com.z);
+			lgm.push_back(node.gm);
+			i = node.skip;
+		}
+		else if (node.leaf) {
+			int end = node.begin + node.count;
+			lx.insert(lx.end(), sx.begin() + node.begin, sx.begin() + end);
+			ly.insert(ly.end(), sy.begin() + node.begin, sy.begin() + end);
+			lz.insert(lz.end(), sz.begin() + node.begin, sz.begin() + end);
+			lgm.insert(lgm.end(), sgm.begin() + node.begin, sgm.begin() + end);
+			i = node.skip;
+		}
+		else
+			i++;
+	}
+
+	//Pad with massless bodies for the kernel
+	size_t padded = (lx.size() + GRAVITY_PADDING - 1) / GRAVITY_PADDING * GRAVITY_PADDING;
+	lx.resize(padded, 0.0f); ly.resize(padded, 0.0f); lz.resize(padded, 0.0f); lgm.resize(padded, 0.0f);
+}
+
+glm::vec3 Octree::get_gravity(glm::vec3 target, float theta, float softening2, GravityKernel kernel) {
+	//Interaction list. Per thread, so it's only allocated once.
+	thread_local std::vector<float> list[4];
+
+	collect(target, target, theta, list);
+	return accumulate_gravity(kernel, list[0].data(), list[1].data(), list[2].data(), list[3].data(), (int) list[0].size(), target, softening2);
+}
+
+void Octree::sort_targets(const glm::vec3 *targets, int n, std::vector<int> *order) {
+	thread_local std::vector<unsigned int> keys, sorted_keys;
+	thread_local std::vector<int> sorted_indices;
+	std::vector<int> &indices = *order;
+
+	//Coarse Morton order in the root cube (outside: clamped to its faces)
+	const float cells = (float) (1 << GROUP_MORTON_BITS);
+	glm::vec3 corner(0.0f);
+	float side = 1.0f;
+	if (!nodes.empty()) {
+		corner = nodes[0].center - glm::vec3(nodes[0].half);
+		side = 2 * nodes[0].half;
+	}
+
+	keys.resize(n);
+	indices.resize(n);
+	for (int i = 0; i < n; i++) {
+		glm::vec3 q = (targets[i] - corner) / side * cells;
+		q = glm::clamp(q, glm::vec3(0.0f), glm::vec3(cells - 1));
+		keys[i] = (unsigned int) (
+			spread_bits((unsigned long long) q.x) << 2 |
+			spread_bits((unsigned long long) q.y) << 1 |
+			spread_bits((unsigned long long) q.z));
+		indices[i] = i;
+	}
+
+	//LSD radix sort, 8 bits a pass
+	sorted_keys.resize(n);
+	sorted_indices.resize(n);
+	for (int shift = 0; shift < 3 * GROUP_MORTON_BITS; shift += 8) {
+		int offsets[257] = {0};
+		for (int i = 0; i < n; i++)
+			offsets[((keys[i] >> shift) & 0xff) + 1]++;
+		for (int b = 0; b < 256; b++)
+			offsets[b + 1] += offsets[b];
+		for (int i = 0; i < n; i++) {
+			int dst = offsets[(keys[i] >> shift) & 0xff]++;
+			sorted_keys[dst] = keys[i];
+			sorted_indices[dst] = indices[i];
+		}
+		keys.swap(sorted_keys);
+		indices.swap(sorted_indices);
+	}
+}
+
+void Octree::get_gravity(const glm::vec3 *targets, const int *order, int n, glm::vec3 *out, float theta, float softening2, GravityKernel kernel) {
+	thread_local std::vector<float> list[4];
+
+	//One interaction list per group, valid for every target in its bounding box
+	for (int begin = 0; begin < n; begin += GROUP_SIZE) {
+		int end = std::min(begin + GROUP_SIZE, n);
+
+		glm::vec3 lo = targets[order[begin]], hi = lo;
+		for (int i = begin + 1; i < end; i++) {
+			lo = glm::min(lo, targets[order[i]]);
+			hi = glm::max(hi, targets[order[i]]);
+		}
+
+		collect(lo, hi, theta, list);
+		for (int i = begin; i < end; i++) {
+			int j = order[i];
+			out[j] = accumulate_gravity(kernel, list[0].data(), list[1].data(), list[2].data(), list[3].data(), (int) list[0].size(), targets[j], softening2);
+		}
+	}
+}
+
+int Octree::get_node_count() {
+	return (int) nodes.size();
+}
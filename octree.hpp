@@ -0,0 +1,58 @@
+#ifndef OCTREE_HPP
+#define OCTREE_HPP
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "gravity.hpp"
+
+/*
+Linear octree for Barnes-Hut.
+Bodies are sorted along a Morton curve and copied, so every node covers a contiguous range of them.
+Nodes are stored depth-first with the index past their subtree (`skip`), so a traversal is a single forward loop without a stack.
+*/
+class Octree {
+public:
+	Octree(int leaf_size=8);
+
+	void build(const float *x, const float *y, const float *z, const float *gm, int n);
+
+	/*
+	Far nodes (`size / distance < theta`, target outside the node) are taken as point masses at their center of mass;
+	the rest are opened down to the bodies of the leaves. The interaction list is then summed by the kernel.
+	Thread-safe once built.
+	*/
+	glm::vec3 get_gravity(glm::vec3 target, float theta, float softening2, GravityKernel kernel);
+
+	/*
+	Many targets: groups of consecutive targets share one interaction list, built against the group's bounding box.
+	`sort_targets()` orders them so that consecutive targets are close; `get_gravity()` takes `order[0, n)` of them.
+	*/
+	void sort_targets(const glm::vec3 *targets, int n, std::vector<int> *order);
+	void get_gravity(const glm::vec3 *targets, const int *order, int n, glm::vec3 *out, float theta, float softening2, GravityKernel kernel);
+
+	int get_node_count();
+
+private:
+	struct Node {
+		glm::vec3 com; //Center of mass
+		float gm;
+		glm::vec3 center; //Of the cube
+		float half; //Half the side of the cube
+		int begin, count; //Sorted bodies
+		int skip;
+		bool leaf;
+	};
+
+	void build_node(int begin, int end, int level, glm::vec3 center, float half);
+	void collect(glm::vec3 lo, glm::vec3 hi, float theta, std::vector<float> *list); //Interaction list of the box [lo, hi], into list[4] (x, y, z, gm)
+
+	int leaf_size;
+	std::vector<Node> nodes;
+
+	std::vector<unsigned long long> codes; //Morton, sorted
+	std::vector<float> sx, sy, sz, sgm; //Bodies in the Morton order
+};
+
+#endif
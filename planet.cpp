@@ -10,7 +10,11 @@
 
 #include <cmath>
 #include <iostream>
+#include <limits>
 
+#include "chunked_terrain.hpp"
+#include "culling.hpp"
+#include "frame.hpp"
 #include "utils.hpp"
 
 Planet::Planet(
@@ -22,79 +26,197 @@ Planet::Planet(
 ) 
 	: drawable(drawable), shader(shader),
 	radius(radius),
-	orbit_freq(orbit_freq), orbit_radius(orbit_radius),
+	orbit(circular_orbit(orbit_radius, orbit_freq)),
 	rot_freq(rot_freq), rot_axis(rot_axis),
+	terrain(nullptr), relief(0.0f), chunks(nullptr),
 	extra_shader_op(extra_shader_op)
 {
-	position = glm::vec3(radius, 0.0f, 0.0f);
-	model = glm::mat4(1.0f);
+	orbit_basis = get_orbit_basis(orbit);
+	orbit_state_time = std::numeric_limits<double>::quiet_NaN(); //Equal to no time
+	position = glm::dvec3(radius, 0.0, 0.0);
+	rot_angle = 0.0f;
+
+	//Headless planets have no shader
+	if (shader != nullptr) {
+		FrameUniforms::bind(shader);
+		model_uniform = shader->getUniform<glm::mat4>("model");
+		normal_matrix_uniform = shader->getUniform<glm::mat3>("normalMatrix");
+	}
+
+	/*
+	G * M = G'*rho*rad^3
+		= K * rho * rad^3
+	*/
+	const float KRHO = 2.56f;
+	gm = KRHO * radius * radius * radius;
 }
 
-void Planet::update() {
-	float time = get_time();
+void Planet::update(double time) {
+	position = get_orbit_position(time);
+	rot_angle = get_rotation_angle(time);
+}
+
+void Planet::draw(glm::dvec3 camera_position, float pixels_per_radian, Culler *culler, RenderQueue *queue) {
+	draw_orbit(camera_position); //Culled with the other shapes
+
+	//The highest the relief goes
+	if (!culler->is_visible(CULL_PLANETS, glm::vec3(position - camera_position), radius * (1.0f + 0.5f * get_relief())))
+		return;
 
-	model = glm::mat4(1.0f);
+	if (chunks != nullptr) {
+		glm::mat3 rotation(glm::rotate(glm::mat4(1.0f), rot_angle, glm::vec3(0.0f, 1.0f, 0.0f)));
+		chunks->draw(position - camera_position, rotation, radius, pixels_per_radian, culler, queue);
+		return;
+	}
 
-	//Translate (orbit)
-	float x = orbit_radius * std::cos(time * orbit_freq * 2*PI);
-	float z = orbit_radius * std::sin(time * orbit_freq * 2*PI);
-	position = glm::vec3(x, 0.0f, z);
-	model = glm::translate(model, position);
-	//std::cout << "Planet loc: " << x << ", " << z << std::endl;	
+	glm::mat4 model = glm::mat4(1.0f);
+
+	//Translate (orbit), relative to the camera in double so only the small difference reaches the GPU
+	model = glm::translate(model, glm::vec3(position - camera_position));
 
 	glm::vec3 rot_axis(0.0f, 1.0f, 0.0f);
-	float rot_angle = time * rot_freq * 2*PI; //radians
 	model = glm::rotate(model, rot_angle, rot_axis);
 	model = glm::scale(model, glm::vec3(radius));
+
+	DrawItem item;
+	item.key = RenderQueue::make_key(PASS_OPAQUE, shader->ID, 0, (float) glm::length(position - camera_position), 0);
+	item.draw = draw_item;
+	item.owner = this;
+	item.data = nullptr;
+	item.model = model;
+	item.count = 0;
+	queue->add(item);
 }
 
-void Planet::draw(glm::mat4 projection, glm::mat4 view) {
-	shader->use();
+void Planet::draw_item(const DrawItem &item) {
+	Planet *planet = (Planet *) item.owner;
 
-	shader->setMat4("projection", projection);
-	shader->setMat4("view", view);
-	shader->setMat4("model", model);
+	planet->shader->use();
 
-	if (extra_shader_op != nullptr)
-		extra_shader_op(shader, this);
+	planet->shader->set(planet->model_uniform, item.model);
+	planet->shader->set(planet->normal_matrix_uniform, glm::transpose(glm::inverse(glm::mat3(item.model)))); //Once, not per vertex
 
-	drawable->draw(shader);
+	if (planet->extra_shader_op != nullptr)
+		planet->extra_shader_op(planet->shader, planet);
 
-	draw_orbit(projection, view);
+	planet->drawable->draw(planet->shader);
 }
 
 float Planet::get_radius() {
 	return radius;
 }
 
-glm::vec3 Planet::get_position() {
+glm::dvec3 Planet::get_position() {
 	return position;
 }
 
-glm::vec3 Planet::get_gravity(glm::vec3 target, float delta_time) {
-	//target TO this->position
-	glm::vec3 diff = position - target;
+glm::dvec3 Planet::get_orbit_position(double time) {
+	glm::dvec3 position, velocity;
+	get_orbit_state(time, &position, &velocity);
+	return position;
+}
 
-	float dist = glm::length(diff);
-	glm::vec3 dir = glm::normalize(diff);
+float Planet::get_rotation_angle(double time) {
+	return (float) std::remainder(time * rot_freq, 1.0) * 2*PI; //radians
+}
 
-	/*
-	G * Mm / dist^2 = G'*m*rho*rad^3 / dist^2
-	Assuming m never changes,
-		K * rho * rad^3 / dist^2
-	*/
+void Planet::set_orbit(const OrbitalElements &orbit) {
+	this->orbit = orbit;
+	orbit_basis = get_orbit_basis(orbit);
+	orbit_state_time = std::numeric_limits<double>::quiet_NaN();
+}
+
+OrbitalElements Planet::get_orbit() {
+	return orbit;
+}
+
+void Planet::get_orbit_state(double time, glm::dvec3 *position, glm::dvec3 *velocity) {
+	if (time != orbit_state_time) {
+		propagate_orbit(orbit, orbit_basis, time, &orbit_state_position, &orbit_state_velocity);
+		orbit_state_time = time;
+	}
+	*position = orbit_state_position;
+	*velocity = orbit_state_velocity;
+}
+
+glm::dvec3 Planet::get_gravity(glm::dvec3 target, double time) {
+	//target TO the position at `time`
+	glm::dvec3 diff = get_orbit_position(time) - target;
+
+	//gm / dist^2 along diff / dist
+	double dist2 = glm::dot(diff, diff);
+	return diff * (gm / (dist2 * std::sqrt(dist2)));
+}
 
-	const float KRHO = 0.005f;
-	float mag = KRHO * std::pow(radius, 3) / std::pow(dist, 2);
-	return mag * delta_time * dir;
+float Planet::get_gm() {
+	return gm;
 }
 
-void Planet::draw_orbit(glm::mat4 projection, glm::mat4 view) {
-	draw_circle(projection, view, glm::vec3(0), orbit_radius); //orbit
-	draw_circle(projection, view, position, radius * 1.1f); //to the planet
+void Planet::set_terrain(Terrain *terrain, float relief) {
+	this->terrain = (terrain != nullptr && terrain->is_loaded()) ? terrain : nullptr;
+	this->relief = relief;
+}
+
+void Planet::set_chunked_terrain(ChunkedTerrain *chunks) {
+	this->chunks = chunks;
+}
+
+glm::vec3 Planet::to_body_frame(glm::vec3 direction, double time) {
+	//Inverse of the rotation about Y in `draw()`
+	float angle = get_rotation_angle(time);
+	float c = std::cos(angle), s = std::sin(angle);
+	return glm::vec3(c * direction.x - s * direction.z, direction.y, s * direction.x + c * direction.z);
+}
+
+float Planet::get_surface_radius(glm::vec3 direction, double time) {
+	if (terrain == nullptr)
+		return radius;
+	float height = terrain->get_height(to_body_frame(direction, time));
+	return radius * (1.0f + relief * (height - 0.5f));
+}
+
+void Planet::get_surface_range(glm::vec3 direction, float angle, double time, float *min_radius, float *max_radius) {
+	if (terrain == nullptr) {
+		*min_radius = *max_radius = radius;
+		return;
+	}
+	float min, max;
+	terrain->get_height_range(to_body_frame(direction, time), angle, &min, &max);
+	*min_radius = radius * (1.0f + relief * (min - 0.5f));
+	*max_radius = radius * (1.0f + relief * (max - 0.5f));
+}
+
+float Planet::get_max_surface_radius() {
+	float min_radius, max_radius;
+	get_surface_range(glm::vec3(0.0f, 1.0f, 0.0f), PI, 0.0, &min_radius, &max_radius); //The whole planet
+	return max_radius;
+}
+
+float Planet::get_surface_angle() {
+	return (terrain == nullptr) ? PI : terrain->get_texel_angle();
+}
+
+float Planet::get_rotation_speed() {
+	return std::abs(rot_freq) * 2*PI;
+}
+
+float Planet::get_rot_freq() {
+	return rot_freq;
+}
+
+float Planet::get_relief() {
+	return (terrain == nullptr) ? 0.0f : relief;
+}
+
+void Planet::draw_orbit(glm::dvec3 camera_position) {
+	glm::vec3 origin(-camera_position);
+	glm::vec3 planet_position(position - camera_position);
+
+	draw_orbit_path(origin, orbit, orbit_basis); //orbit
+	draw_circle(planet_position, radius * 1.1f); //to the planet
 
-	draw_line(projection, view, glm::vec3(0), position); //to the sun;
+	draw_line(origin, planet_position); //to the sun;
 
-	draw_line(projection, view, glm::vec3(0), glm::vec3(0, 3, 0)); //To world up
-	draw_cube(projection, view, glm::vec3(0)); //origin
+	draw_line(origin, origin + glm::vec3(0, 3, 0)); //To world up
+	draw_cube(origin); //origin
 }
\ No newline at end of file
@@ -4,6 +4,13 @@
 #include <glm/glm.hpp>
 #include <learnopengl/shader_m.h>
 
+#include "integrator.hpp"
+#include "kepler.hpp"
+#include "render_queue.hpp"
+#include "terrain.hpp"
+
+class ChunkedTerrain;
+class Culler;
 class Planet;
 using ExtraShaderOpT = void (*)(Shader *, Planet *);
 
@@ -12,7 +19,7 @@ public:
 	virtual void draw(Shader *shader) = 0;
 };
 
-class Planet {
+class Planet : public GravityField {
 public:
 	Planet(
 		Drawable *drawable, Shader *shader,
@@ -22,28 +29,61 @@ public:
 		ExtraShaderOpT extra_shader_op=nullptr
 	);
 
-	void update();
-	void draw(glm::mat4 projection, glm::mat4 view);
+	void update(double time); //Places the planet at `time`
+	//The camera of `FrameUniforms` is at the origin; the model is built relative to `camera_position`.
+	//`pixels_per_radian`: at the center of the screen, for the detail of the chunked terrain.
+	//The planet's draws go to `queue`, unless `culler` rejects it; its orbit goes to the shapes either way.
+	void draw(glm::dvec3 camera_position, float pixels_per_radian, Culler *culler, RenderQueue *queue);
 
 	float get_radius();
-	glm::vec3 get_position();
+	glm::dvec3 get_position();
+
+	glm::dvec3 get_gravity(glm::dvec3 target, double time) override; //Acceleration, with the planet placed at `time`
+	float get_gm();
 
-	glm::vec3 get_gravity(glm::vec3 target, float delta_time);
+	void set_orbit(const OrbitalElements &orbit); //Replaces the circular orbit of the constructor
+	OrbitalElements get_orbit();
+	//On the orbit at `time`, without placing the planet. Remembers the last one (a step asks for its end twice), so not thread-safe.
+	void get_orbit_state(double time, glm::dvec3 *position, glm::dvec3 *velocity);
+
+	//Surface radius: radius * (1 + relief * (height - 0.5)), or just radius without terrain
+	void set_terrain(Terrain *terrain, float relief); //Not owned; shared read-only
+	float get_surface_radius(glm::vec3 direction, double time); //Under `direction` from the center, turned as at `time`
+	void get_surface_range(glm::vec3 direction, float angle, double time, float *min_radius, float *max_radius); //Over a cap of `angle` radians
+	float get_max_surface_radius();
+	float get_surface_angle(); //Smallest relief feature, radians
+	float get_rotation_speed(); //Radians per second
+	float get_rot_freq();
+	float get_relief(); //0 without terrain
+	void set_chunked_terrain(ChunkedTerrain *chunks); //Drawn instead of the `drawable` if set. Not owned.
 
 private:
-	void draw_orbit(glm::mat4 projection, glm::mat4 view);
+	glm::dvec3 get_orbit_position(double time);
+	float get_rotation_angle(double time);
+	glm::vec3 to_body_frame(glm::vec3 direction, double time); //Undoes the rotation at `time`
+	void draw_orbit(glm::dvec3 camera_position);
+	static void draw_item(const DrawItem &item); //Of the `drawable`
 
 	Drawable *drawable;
 	Shader *shader;
+	Uniform<glm::mat4> model_uniform; //Of `shader`
+	Uniform<glm::mat3> normal_matrix_uniform;
 
 	float radius;
-	float orbit_freq;
-	float orbit_radius;
+	float gm;
+	OrbitalElements orbit;
+	OrbitBasis orbit_basis; //Of `orbit`
+	double orbit_state_time; //Of the last `get_orbit_state()`
+	glm::dvec3 orbit_state_position, orbit_state_velocity;
 	float rot_freq;
 	glm::vec3 rot_axis;
 
-	glm::vec3 position;
-	glm::mat4 model;
+	Terrain *terrain;
+	float relief;
+	ChunkedTerrain *chunks;
+
+	glm::dvec3 position;
+	float rot_angle;
 
 	ExtraShaderOpT extra_shader_op;
 };
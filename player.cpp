@@ -8,43 +8,59 @@
 
 #include <iostream>
 
-Player::Player(glm::vec3 position, float pitch, float yaw) : position(position), pitch(pitch), yaw(yaw) {
-	velocity = glm::vec3(0.0f);
-	last_gravity = glm::vec3(0.0f);
+Player::Player(glm::dvec3 position, float pitch, float yaw) : pitch(pitch), yaw(yaw) {
+	state.position = prev_position = render_position = position;
+	state.velocity = glm::dvec3(0.0);
 }
 
 void Player::process_input(float forward_offset, float pitch_offset, float yaw_offset) {
 	pitch += pitch_offset;
 	yaw += yaw_offset;
 
-	const float forward_sensitivity = 0.01f;
-	velocity += get_front() * forward_offset * forward_sensitivity;
+	const float forward_sensitivity = 5.12f;
+	state.velocity += glm::dvec3(get_front() * forward_offset * forward_sensitivity);
 }
 
-void Player::add_gravity(glm::vec3 gravity) {
-	velocity += gravity;
-	last_gravity = gravity;
+void Player::integrate(Integrator *integrator, GravityField *field, double time, float delta_time) {
+	prev_position = state.position;
+	integrator->step(&state, time, delta_time, field);
 }
 
-void Player::set_position(glm::vec3 position) {
-	this->position = position;
+void Player::interpolate(float alpha) {
+	render_position = glm::mix(prev_position, state.position, (double) alpha);
 }
 
-glm::vec3 Player::get_position() {
-	static float last_time = -1;
-	float time = get_time();
-	if (last_time < 0)
-		last_time = time;
-	float delta_time = time - last_time;
-	last_time = time;
-
-	const float multiplier = 512.0f;
-	position += velocity * multiplier * delta_time;
-	return position;
+void Player::set_position(glm::dvec3 position) {
+	state.position = prev_position = render_position = position;
 }
 
-glm::vec3 Player::get_velocity() {
-	return velocity;
+void Player::set_state(const BodyState &state) {
+	prev_position = this->state.position;
+	this->state = state;
+}
+
+float Player::get_pitch() {
+	return pitch;
+}
+
+float Player::get_yaw() {
+	return yaw;
+}
+
+glm::dvec3 Player::get_position() {
+	return state.position;
+}
+
+glm::dvec3 Player::get_render_position() {
+	return render_position;
+}
+
+glm::dvec3 Player::get_velocity() {
+	return state.velocity;
+}
+
+BodyState Player::get_state() {
+	return state;
 }
 
 void Player::get_camera_vecs(glm::vec3 *front, glm::vec3 *right, glm::vec3 *up) {
@@ -68,11 +84,13 @@ glm::vec3 Player::get_front() {
 	return front;
 }
 
-void Player::draw_lines(glm::mat4 projection, glm::mat4 view, glm::vec3 planet_pos) {
-	const float multiplier = 5.0f;
-	glm::vec3 front_pos = position + get_front();
-	glm::vec3 velocity_pos = front_pos + velocity * multiplier;
+void Player::draw_lines(glm::dvec3 camera_position, glm::dvec3 planet_pos) {
+	//Relative to the camera
+	const float multiplier = 0.01f;
+	glm::vec3 front_pos = glm::vec3(render_position - camera_position) + get_front();
+	glm::vec3 velocity_pos = front_pos + glm::vec3(state.velocity) * multiplier;
+	glm::vec3 planet_render_pos(planet_pos - camera_position);
 
-	draw_line(projection, view, front_pos, velocity_pos, glm::vec4(1, 1, 0, 1)); //yellow
-	draw_line(projection, view, velocity_pos, planet_pos, glm::vec4(1, 1, 1, 1)); //white
+	draw_line(front_pos, velocity_pos, glm::vec4(1, 1, 0, 1)); //yellow
+	draw_line(velocity_pos, planet_render_pos, glm::vec4(1, 1, 1, 1)); //white
 }
\ No newline at end of file
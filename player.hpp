@@ -3,29 +3,36 @@
 
 #include <glm/glm.hpp>
 
+#include "integrator.hpp"
+
 class Player {
 public:
-	Player(glm::vec3 position, float front, float yaw);
+	Player(glm::dvec3 position, float front, float yaw);
 
 	void process_input(float forward_offset, float pitch_offset, float yaw_offset);
-	void add_gravity(glm::vec3 gravity);
-
-	glm::vec3 get_position();
-	void set_position(glm::vec3 position); //init.
-	glm::vec3 get_velocity();
+	void integrate(Integrator *integrator, GravityField *field, double time, float delta_time); //Advances the state by one step
+	void interpolate(float alpha); //Sets the render position between the last two steps
+
+	glm::dvec3 get_position();
+	glm::dvec3 get_render_position();
+	void set_position(glm::dvec3 position); //init.
+	glm::dvec3 get_velocity();
+	BodyState get_state();
+	void set_state(const BodyState &state); //Moves the ship as a step would, e.g. on rails
+	float get_pitch();
+	float get_yaw();
 	void get_camera_vecs(glm::vec3 *front, glm::vec3 *right, glm::vec3 *up);
 
-	void draw_lines(glm::mat4 projection, glm::mat4 view, glm::vec3 planet_pos);
+	void draw_lines(glm::dvec3 camera_position, glm::dvec3 planet_pos);
 
 private:
 	glm::vec3 get_front();
 
-	glm::vec3 position;
+	BodyState state;
+	glm::dvec3 prev_position;
+	glm::dvec3 render_position;
 	float pitch;
 	float yaw;
-
-	glm::vec3 velocity;
-	glm::vec3 last_gravity;
 };
 
 #endif
\ No newline at end of file
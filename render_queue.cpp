@@ -0,0 +1,75 @@
+#include "render_queue.hpp"
+
+#include <cstring>
+
+RenderQueue::RenderQueue() : items(1024), count(0), size(0) {}
+
+uint64_t RenderQueue::make_key(RenderPass pass, unsigned int shader, unsigned int material, float depth, unsigned int VAO) {
+	//A positive float's bits grow with it; the top 24 keep the exponent and 15 bits of the mantissa
+	uint32_t depth_bits = 0;
+	if (depth > 0.0f)
+		memcpy(&depth_bits, &depth, sizeof (depth_bits));
+
+	return ((uint64_t) (pass & 0x3) << 62)
+		| ((uint64_t) (shader & 0xff) << 54)
+		| ((uint64_t) (material & 0x3ff) << 44)
+		| ((uint64_t) (depth_bits >> 8) << 20)
+		| (uint64_t) (VAO & 0xfffff);
+}
+
+void RenderQueue::add(const DrawItem &item) {
+	int i = count.fetch_add(1, std::memory_order_relaxed);
+	if (i < (int) items.size()) {
+		items[i] = item;
+		return;
+	}
+	std::lock_guard<std::mutex> lock(overflow_mutex);
+	overflow.push_back(item);
+}
+
+void RenderQueue::submit() {
+	size = count.load();
+	if (!overflow.empty()) {
+		items.insert(items.end(), overflow.begin(), overflow.end());
+		overflow.clear();
+	}
+
+	sort(size);
+	for (int i = 0; i < size; i++) {
+		const DrawItem &item = items[entries[i].index];
+		item.draw(item);
+	}
+	count = 0;
+}
+
+int RenderQueue::get_size() {
+	return size;
+}
+
+//LSD, a byte at a time; the bytes all keys share (the unused passes, a lone shader...) are skipped
+void RenderQueue::sort(int n) {
+	entries.resize(n);
+	scratch.resize(n);
+	for (int i = 0; i < n; i++)
+		entries[i] = SortEntry{items[i].key, i};
+	if (n < 2)
+		return;
+
+	for (int shift = 0; shift < 64; shift += 8) {
+		int offsets[256] = {0};
+		for (int i = 0; i < n; i++)
+			offsets[(entries[i].key >> shift) & 0xff]++;
+		if (offsets[(entries[0].key >> shift) & 0xff] == n)
+			continue;
+
+		int offset = 0;
+		for (int b = 0; b < 256; b++) {
+			int c = offsets[b];
+			offsets[b] = offset;
+			offset += c;
+		}
+		for (int i = 0; i < n; i++)
+			scratch[offsets[(entries[i].key >> shift) & 0xff]++] = entries[i];
+		entries.swap(scratch);
+	}
+}
@@ -0,0 +1,66 @@
+#ifndef RENDER_QUEUE_HPP
+#define RENDER_QUEUE_HPP
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+//In the order they are drawn
+enum RenderPass {
+	PASS_OPAQUE,
+	PASS_SHAPES, //Debug lines, rings, cubes and orbits
+	PASS_SKY //Last, where the depth buffer is still clear
+};
+
+struct DrawItem;
+using DrawFnT = void (*)(const DrawItem &item);
+
+//One draw call, with what `draw` needs to issue it
+struct DrawItem {
+	uint64_t key; //`RenderQueue::make_key()`
+	DrawFnT draw;
+	void *owner; //For `draw`: the object drawing
+	void *data; //and what it draws
+	glm::mat4 model;
+	int count; //Vertices, instances...
+};
+
+/*
+Draws of a frame, added in any order (from any thread) and submitted sorted by key: by pass, then shader, then material,
+so programs and textures change as little as `GLState` can skip; then front to back, so the depth test rejects hidden fragments early.
+The keys are radix sorted, along with the items' indices; the items themselves don't move.
+Storage is kept from frame to frame, so a steady frame doesn't allocate.
+*/
+class RenderQueue {
+public:
+	RenderQueue();
+
+	//Bits, from the top: pass 2, shader 8, material 10, depth 24, VAO 20. IDs are GL names, wrapped; they only group draws.
+	//Depth is the distance to the camera; each chunk has its own VAO, so depth comes before it.
+	static uint64_t make_key(RenderPass pass, unsigned int shader, unsigned int material, float depth, unsigned int VAO);
+
+	void add(const DrawItem &item); //Thread-safe; not during `submit()`
+	void submit(); //Sorts and draws everything added since the last submit, then clears. Render thread.
+
+	int get_size(); //Of the last submit
+
+private:
+	struct SortEntry {
+		uint64_t key;
+		int index;
+	};
+
+	void sort(int n);
+
+	std::vector<DrawItem> items; //Slots taken by an atomic counter
+	std::atomic<int> count;
+	std::mutex overflow_mutex;
+	std::vector<DrawItem> overflow; //Past the slots; they grow to fit at the next submit
+	std::vector<SortEntry> entries, scratch;
+	int size;
+};
+
+#endif
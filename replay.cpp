@@ -0,0 +1,208 @@
+#include "replay.hpp"
+
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include "planet.hpp"
+#include "player.hpp"
+#include "simulation.hpp"
+#include "terrain.hpp"
+
+const int REPLAY_VERSION = 4;
+
+//Record flags
+const unsigned char RECORD_WARP = 1;
+const unsigned char RECORD_FORWARD = 2;
+const unsigned char RECORD_PITCH = 4;
+const unsigned char RECORD_YAW = 8;
+const unsigned char RECORD_RESET = 16;
+
+ReplayHeader make_replay_header(Simulation *simulation, Planet *planet, Player *player) {
+	ReplayHeader header;
+	std::memset(&header, 0, sizeof header); //Padding too, so equal setups give equal files
+	std::memcpy(header.magic, "SLRP", 4);
+	header.version = REPLAY_VERSION;
+
+	header.integrator_type = (int) simulation->get_integrator_type();
+	header.step_size = simulation->get_step_size();
+	header.max_steps = simulation->get_max_steps();
+
+	header.planet_radius = planet->get_radius();
+	header.planet_orbit = planet->get_orbit();
+	header.planet_rot_freq = planet->get_rot_freq();
+	header.planet_relief = planet->get_relief();
+
+	header.player_state = player->get_state();
+	header.player_pitch = player->get_pitch();
+	header.player_yaw = player->get_yaw();
+	return header;
+}
+
+static void hash_bytes(unsigned long long *hash, const void *data, size_t size) {
+	const unsigned char *bytes = (const unsigned char *) data;
+	for (size_t i = 0; i < size; i++)
+		*hash = (*hash ^ bytes[i]) * 1099511628211ULL;
+}
+
+unsigned long long hash_state(Simulation *simulation, Player *player) {
+	BodyState state = player->get_state();
+	float angles[2] = {player->get_pitch(), player->get_yaw()};
+	double time = simulation->get_time();
+	long long ticks = simulation->get_ticks();
+
+	unsigned long long hash = 14695981039346656037ULL;
+	hash_bytes(&hash, &state.position, sizeof state.position);
+	hash_bytes(&hash, &state.velocity, sizeof state.velocity);
+	hash_bytes(&hash, angles, sizeof angles);
+	hash_bytes(&hash, &time, sizeof time);
+	hash_bytes(&hash, &ticks, sizeof ticks);
+	return hash;
+}
+
+ReplayRecorder::ReplayRecorder(const char *path, const ReplayHeader &header) : header(header) {
+	warp = 1.0f;
+	file = std::fopen(path, "wb");
+	if (file == nullptr) {
+		std::cout << "Failed to open the replay file: " << path << std::endl;
+		return;
+	}
+	std::fwrite(&this->header, sizeof this->header, 1, file);
+}
+
+ReplayRecorder::~ReplayRecorder() {
+	if (file != nullptr)
+		std::fclose(file);
+}
+
+bool ReplayRecorder::is_open() {
+	return file != nullptr;
+}
+
+void ReplayRecorder::record(const FrameInput &input) {
+	if (file == nullptr)
+		return;
+
+	unsigned char flags = 0;
+	if (input.warp != warp) flags |= RECORD_WARP;
+	if (input.forward_offset != 0.0f) flags |= RECORD_FORWARD;
+	if (input.pitch_offset != 0.0f) flags |= RECORD_PITCH;
+	if (input.yaw_offset != 0.0f) flags |= RECORD_YAW;
+	if (input.reset) flags |= RECORD_RESET;
+
+	std::fwrite(&flags, 1, 1, file);
+	std::fwrite(&input.frame_time, sizeof(float), 1, file);
+	if (flags & RECORD_WARP) std::fwrite(&input.warp, sizeof(float), 1, file);
+	if (flags & RECORD_FORWARD) std::fwrite(&input.forward_offset, sizeof(float), 1, file);
+	if (flags & RECORD_PITCH) std::fwrite(&input.pitch_offset, sizeof(float), 1, file);
+	if (flags & RECORD_YAW) std::fwrite(&input.yaw_offset, sizeof(float), 1, file);
+
+	warp = input.warp;
+	header.frames++;
+}
+
+void ReplayRecorder::finish(unsigned long long final_hash) {
+	if (file == nullptr)
+		return;
+
+	header.final_hash = final_hash;
+	std::fseek(file, 0, SEEK_SET);
+	std::fwrite(&header, sizeof header, 1, file);
+	std::fclose(file);
+	file = nullptr;
+}
+
+ReplayReader::ReplayReader(const char *path) {
+	warp = 1.0f;
+	file = std::fopen(path, "rb");
+	if (file == nullptr)
+		return;
+
+	if (std::fread(&header, sizeof header, 1, file) != 1
+		|| std::memcmp(header.magic, "SLRP", 4) != 0 || header.version != REPLAY_VERSION) {
+		std::fclose(file);
+		file = nullptr;
+	}
+}
+
+ReplayReader::~ReplayReader() {
+	if (file != nullptr)
+		std::fclose(file);
+}
+
+bool ReplayReader::is_open() {
+	return file != nullptr;
+}
+
+const ReplayHeader &ReplayReader::get_header() {
+	return header;
+}
+
+bool ReplayReader::next(FrameInput *input) {
+	if (file == nullptr)
+		return false;
+
+	unsigned char flags;
+	if (std::fread(&flags, 1, 1, file) != 1 || std::fread(&input->frame_time, sizeof(float), 1, file) != 1)
+		return false;
+
+	input->warp = warp;
+	input->forward_offset = input->pitch_offset = input->yaw_offset = 0.0f;
+	bool ok = true;
+	if (flags & RECORD_WARP) ok = ok && std::fread(&input->warp, sizeof(float), 1, file) == 1;
+	if (flags & RECORD_FORWARD) ok = ok && std::fread(&input->forward_offset, sizeof(float), 1, file) == 1;
+	if (flags & RECORD_PITCH) ok = ok && std::fread(&input->pitch_offset, sizeof(float), 1, file) == 1;
+	if (flags & RECORD_YAW) ok = ok && std::fread(&input->yaw_offset, sizeof(float), 1, file) == 1;
+	input->reset = (flags & RECORD_RESET) != 0;
+
+	warp = input->warp;
+	return ok;
+}
+
+int run_replay(const char *path) {
+	ReplayReader reader(path);
+	if (!reader.is_open()) {
+		std::cout << "Not a replay file: " << path << std::endl;
+		return -1;
+	}
+	const ReplayHeader &header = reader.get_header();
+
+	//Same setup as the recording, without drawing
+	Planet planet(nullptr, nullptr, header.planet_radius, 0.0f, 0.0f, header.planet_rot_freq, glm::vec3(0.0f, 1.0f, 0.0f));
+	planet.set_orbit(header.planet_orbit);
+	Terrain terrain;
+	if (header.planet_relief > 0.0f && terrain.load(MARS_MESH_PATH, MARS_BUMP_PATH))
+		planet.set_terrain(&terrain, header.planet_relief);
+	Player player(header.player_state.position, header.player_pitch, header.player_yaw);
+	player.set_state(header.player_state);
+	Simulation simulation(&planet, &player, (IntegratorType) header.integrator_type, header.step_size, header.max_steps);
+
+	//As the render loop: input, then the frame
+	FrameInput input;
+	long long frames = 0;
+	int resets = 0;
+	auto start = std::chrono::steady_clock::now();
+	while (reader.next(&input)) {
+		player.process_input(input.forward_offset, input.pitch_offset, input.yaw_offset);
+		simulation.set_warp(input.warp);
+		simulation.advance(input.frame_time);
+		if (input.reset)
+			resets++;
+		frames++;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	unsigned long long hash = hash_state(&simulation, &player);
+	printf("Frames: %lld/%lld, ticks: %lld, simulated: %.2f s, score resets: %d\n",
+		frames, header.frames, simulation.get_ticks(), simulation.get_time(), resets);
+	printf("Replayed in %.3f s (%.0f ticks/s, %.0fx real time)\n",
+		seconds, simulation.get_ticks() / seconds, simulation.get_time() / seconds);
+	printf("Final state hash: %016llx, recorded: %016llx, %s\n",
+		hash, header.final_hash, hash == header.final_hash ? "match" : "MISMATCH");
+	if (simulation.has_contact())
+		printf("Touched down at %.4f s\n", simulation.get_contact().time);
+
+	return frames == header.frames && hash == header.final_hash ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+#ifndef REPLAY_HPP
+#define REPLAY_HPP
+
+#include <glm/glm.hpp>
+
+#include <cstdio>
+
+#include "integrator.hpp"
+#include "kepler.hpp"
+
+class Planet;
+class Player;
+class Simulation;
+
+//What a frame feeds to the simulation
+struct FrameInput {
+	float frame_time;
+	float warp;
+	float forward_offset;
+	float pitch_offset;
+	float yaw_offset;
+	bool reset; //Of the score
+};
+
+/*
+Start of a replay file: the setup and the initial state.
+`frames` and `final_hash` are filled in when the recording finishes.
+*/
+struct ReplayHeader {
+	char magic[4]; //"SLRP"
+	int version;
+
+	int integrator_type;
+	float step_size;
+	int max_steps;
+
+	float planet_radius;
+	OrbitalElements planet_orbit;
+	float planet_rot_freq;
+	float planet_relief; //0 without terrain
+
+	BodyState player_state;
+	float player_pitch;
+	float player_yaw;
+
+	long long frames;
+	unsigned long long final_hash;
+};
+
+ReplayHeader make_replay_header(Simulation *simulation, Planet *planet, Player *player);
+unsigned long long hash_state(Simulation *simulation, Player *player); //FNV-1a of the ship, the clock and the ticks
+
+/*
+Writes the inputs of every frame after the header.
+A record is a flags byte and the frame time, then the warp if it changed and the nonzero offsets; an idle frame takes 5 bytes.
+*/
+class ReplayRecorder {
+public:
+	ReplayRecorder(const char *path, const ReplayHeader &header);
+	~ReplayRecorder();
+
+	bool is_open();
+	void record(const FrameInput &input);
+	void finish(unsigned long long final_hash); //Rewrites the header and closes
+
+private:
+	FILE *file;
+	ReplayHeader header;
+	float warp;
+};
+
+class ReplayReader {
+public:
+	ReplayReader(const char *path);
+	~ReplayReader();
+
+	bool is_open(); //false if missing or not a replay
+	const ReplayHeader &get_header();
+	bool next(FrameInput *input); //false at the end
+
+private:
+	FILE *file;
+	ReplayHeader header;
+	float warp;
+};
+
+//Re-simulates a replay headless, as fast as possible. Returns 0 if the final state matches the recording.
+int run_replay(const char *path);
+
+#endif
@@ -0,0 +1,17 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec4 aLocationScale; // per instance
+layout (location = 2) in vec4 aColor; // per instance
+
+out vec4 Color;
+
+layout (std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
+void main() {
+	Color = aColor;
+	gl_Position = projection * view * vec4(aLocationScale.xyz + aLocationScale.w * aPos, 1.0);
+}
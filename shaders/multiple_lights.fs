@@ -48,10 +48,18 @@ in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
 
-uniform vec3 viewPos;
-uniform DirLight dirLight;
+layout (std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
+layout (std140) uniform Lights {
+    DirLight dirLight;
+    SpotLight spotLight;
+};
+
 uniform PointLight pointLights[NR_POINT_LIGHTS];
-uniform SpotLight spotLight;
 uniform Material material;
 
 // function prototypes
@@ -0,0 +1,30 @@
+#version 330 core
+out vec4 Color;
+
+layout (std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
+// 4 texels per orbit: (focus, a), (p, e), (q, segments), color
+uniform samplerBuffer orbits;
+uniform int stride; // vertex IDs per orbit
+
+void main() {
+	int orbit = gl_VertexID / stride;
+	int i = gl_VertexID - orbit * stride;
+
+	vec4 focusA = texelFetch(orbits, orbit * 4 + 0);
+	vec4 pE = texelFetch(orbits, orbit * 4 + 1);
+	vec4 qSegments = texelFetch(orbits, orbit * 4 + 2);
+	Color = texelFetch(orbits, orbit * 4 + 3);
+
+	// evenly spaced in eccentric anomaly; the last vertex closes the loop
+	float eccAnomaly = 6.2831853 * float(i) / qSegments.w;
+	float a = focusA.w, e = pE.w;
+	float b = a * sqrt(1.0 - e * e);
+	vec3 pos = focusA.xyz + pE.xyz * (a * (cos(eccAnomaly) - e)) + qSegments.xyz * (b * sin(eccAnomaly));
+
+	gl_Position = projection * view * vec4(pos, 1.0);
+}
@@ -8,12 +8,17 @@ out vec3 Normal;
 out vec2 TexCoords;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform mat3 normalMatrix; // transpose(inverse(mat3(model))), from the CPU once per draw
+
+layout (std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
 
 void main() {
     FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;  
+    Normal = normalMatrix * aNormal;
     TexCoords = aTexCoords;
     
     gl_Position = projection * view * vec4(FragPos, 1.0);
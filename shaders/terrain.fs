@@ -0,0 +1,46 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 Normal;
+in float Height;
+
+struct DirLight {
+    vec3 direction;
+	
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct SpotLight {
+    vec3 position;
+    vec3 direction;
+    float cutOff;
+    float outerCutOff;
+  
+    float constant;
+    float linear;
+    float quadratic;
+  
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;       
+};
+
+layout (std140) uniform Lights {
+    DirLight dirLight;
+    SpotLight spotLight;
+};
+
+// by height, from the lowlands to the peaks
+const vec3 LOW_COLOR = vec3(0.35, 0.16, 0.08);
+const vec3 HIGH_COLOR = vec3(0.85, 0.62, 0.45);
+
+void main() {
+    vec3 norm = normalize(Normal);
+    vec3 lightDir = normalize(-dirLight.direction);
+    float diff = max(dot(norm, lightDir), 0.0);
+
+    vec3 albedo = mix(LOW_COLOR, HIGH_COLOR, Height);
+    FragColor = vec4((dirLight.ambient + dirLight.diffuse * diff) * albedo, 1.0);
+}
@@ -0,0 +1,21 @@
+#version 330 core
+layout (location = 0) in vec3 aPos; // relative to the chunk's center
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in float aHeight;
+
+out vec3 Normal;
+out float Height;
+
+uniform mat4 model; // rotation and uniform scale only, besides the translation
+
+layout (std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
+void main() {
+    Normal = mat3(model) * aNormal;
+    Height = aHeight;
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
@@ -0,0 +1,254 @@
+#include "simulation.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+
+#include "kepler.hpp"
+#include "landing.hpp"
+
+const float STEP_ACCURACY = 0.02f; //Max. step, as a fraction of sqrt(r^3 / GM) around the planet
+const float MAX_COAST_ECCENTRICITY = 0.95f; //Beyond this, float Kepler propagation is too coarse
+const float MAX_COAST_PERTURBATION = 0.01f; //Planet's own acceleration over its pull at the apoapsis; the coast ignores it
+const int MAX_WARP_STEPS = 1024; //Per `advance()` when warping
+const int WARP_STEP_INTERVAL = 16; //Steps between re-sizing the warped step, as the ship moves
+
+Simulation::Simulation(
+	Planet *planet, Player *player,
+	IntegratorType integrator_type,
+	float step_size, int max_steps
+)
+	: planet(planet), player(player), integrator_type(integrator_type),
+	step_size(step_size), max_steps(max_steps)
+{
+	integrator = new_integrator(integrator_type);
+	ticks = 0;
+	time = 0.0;
+	accumulator = 0.0;
+	last_step = step_size;
+	warp = 1.0f;
+	coasting = false;
+	contact_found = false;
+	planet_state_time = -1.0;
+}
+
+Simulation::~Simulation() {
+	delete integrator;
+}
+
+void Simulation::advance(float frame_time) {
+	accumulator += (double) frame_time * warp;
+	coasting = false;
+
+	//Too much time for accurate steps: coast on rails if the ship can
+	if (warp > 1.0f && get_warp_step(MAX_WARP_STEPS, false) > get_max_step())
+		coast();
+
+	if (!coasting) {
+		int budget = (warp > 1.0f) ? MAX_WARP_STEPS : max_steps;
+		int steps = 0;
+		float step = step_size;
+		while (steps < budget) {
+			if (warp > 1.0f && steps % WARP_STEP_INTERVAL == 0)
+				step = get_warp_step(budget - steps, true);
+			if (accumulator < step)
+				break;
+
+			this->step(step);
+			accumulator -= step;
+			steps++;
+		}
+
+		//Stalled or capped; don't try to catch up
+		if (accumulator >= step)
+			accumulator = 0.0;
+	}
+
+	planet->update(get_render_time());
+	player->interpolate(get_alpha());
+}
+
+void Simulation::step(float step) {
+	BodyState start = player->get_state();
+	player->integrate(integrator, planet, time, step);
+	if (!contact_found)
+		detect_contact(start, step);
+
+	time += step;
+	last_step = step;
+	ticks++;
+}
+
+//The planet's surface over a step, in its own frame
+class StepSurface : public Surface {
+public:
+	StepSurface(Planet *planet, double time, float step) : planet(planet), time(time), step(step) {}
+
+	float get_max_radius() override {
+		return planet->get_max_surface_radius();
+	}
+
+	float get_max_radius(glm::vec3 direction, float angle) override {
+		//Widened by how far the planet turns over the step
+		float min_radius, max_radius;
+		planet->get_surface_range(direction, angle + planet->get_rotation_speed() * step, time, &min_radius, &max_radius);
+		return max_radius;
+	}
+
+	float get_radius(glm::vec3 position, float s) override {
+		return planet->get_surface_radius(position, time + (double) s * step);
+	}
+
+	float get_feature_angle() override {
+		return planet->get_surface_angle();
+	}
+
+private:
+	Planet *planet;
+	double time;
+	float step;
+};
+
+void Simulation::detect_contact(const BodyState &start, float step) {
+	BodyState planet_start = get_planet_state(time);
+	BodyState planet_end = get_planet_state(time + step);
+
+	//Relative to the planet; the ship is a sphere of `LANDING_ALTITUDE` swept against it
+	BodyState end = player->get_state();
+	BodyState relative_start = {start.position - planet_start.position, start.velocity - planet_start.velocity};
+	BodyState relative_end = {end.position - planet_end.position, end.velocity - planet_end.velocity};
+	StepSurface surface(planet, time, step);
+	float s = get_time_of_impact(relative_start, relative_end, step, &surface, LANDING_ALTITUDE);
+	if (s < 0.0f)
+		return;
+
+	contact_found = true;
+	contact.time = time + (double) s * step;
+	BodyState planet_contact = get_planet_state(contact.time);
+	BodyState relative = interpolate_step(relative_start, relative_end, step, s);
+	contact.planet_position = planet_contact.position;
+	contact.state.position = planet_contact.position + relative.position;
+	contact.state.velocity = planet_contact.velocity + relative.velocity;
+}
+
+BodyState Simulation::get_planet_state(double time) {
+	if (time != planet_state_time) {
+		planet->get_orbit_state(time, &planet_state.position, &planet_state.velocity);
+		planet_state_time = time;
+	}
+	return planet_state;
+}
+
+float Simulation::get_warp_step(int steps, bool accurate) {
+	float step = step_size;
+	while (accumulator / step > steps)
+		step *= 2;
+
+	if (accurate) {
+		//As large as stays accurate: the same time in fewer steps
+		float max_step = get_max_step();
+		while (step * 2 <= max_step && step * 2 <= accumulator)
+			step *= 2;
+		while (step > step_size && step > max_step)
+			step /= 2;
+	}
+	return step;
+}
+
+float Simulation::get_max_step() {
+	glm::dvec3 planet_position, planet_velocity;
+	planet->get_orbit_state(time, &planet_position, &planet_velocity);
+	float dist = (float) glm::length(player->get_position() - planet_position);
+	return STEP_ACCURACY * std::sqrt(dist * dist * dist / planet->get_gm());
+}
+
+bool Simulation::coast() {
+	//Ship relative to the planet; both are on rails from here
+	glm::dvec3 planet_position, planet_velocity;
+	planet->get_orbit_state(time, &planet_position, &planet_velocity);
+	BodyState state = player->get_state();
+
+	//Elements from now on, so the float orbit doesn't carry the absolute time
+	OrbitalElements orbit;
+	glm::vec3 relative_position(state.position - planet_position), relative_velocity(state.velocity - planet_velocity);
+	if (!get_orbital_elements(relative_position, relative_velocity, planet->get_gm(), 0.0f, &orbit))
+		return false;
+	if (orbit.eccentricity > MAX_COAST_ECCENTRICITY || orbit.semi_major_axis * (1 - orbit.eccentricity) < planet->get_max_surface_radius() + LANDING_ALTITUDE)
+		return false; //Would hit the planet
+
+	//The planet is on rails around its own focus; the relative orbit only holds while that acceleration is small
+	OrbitalElements planet_orbit = planet->get_orbit();
+	float planet_dist = (float) glm::length(planet_position);
+	float planet_accel = planet_orbit.mean_motion * planet_orbit.mean_motion
+		* planet_orbit.semi_major_axis * planet_orbit.semi_major_axis * planet_orbit.semi_major_axis / (planet_dist * planet_dist);
+	float apoapsis = orbit.semi_major_axis * (1 + orbit.eccentricity);
+	if (planet_accel > MAX_COAST_PERTURBATION * planet->get_gm() / (apoapsis * apoapsis))
+		return false;
+
+	time += accumulator;
+	last_step = (float) accumulator;
+	accumulator = 0.0;
+	ticks++;
+
+	glm::vec3 position, velocity;
+	planet->get_orbit_state(time, &planet_position, &planet_velocity);
+	propagate_orbit(orbit, last_step, &position, &velocity);
+	state.position = planet_position + glm::dvec3(position);
+	state.velocity = planet_velocity + glm::dvec3(velocity);
+	player->set_state(state);
+
+	coasting = true;
+	return true;
+}
+
+void Simulation::set_warp(float warp) {
+	this->warp = warp;
+}
+
+float Simulation::get_warp() {
+	return warp;
+}
+
+bool Simulation::is_coasting() {
+	return coasting;
+}
+
+bool Simulation::has_contact() {
+	return contact_found;
+}
+
+const Contact &Simulation::get_contact() {
+	return contact;
+}
+
+void Simulation::clear_contact() {
+	contact_found = false;
+}
+
+long long Simulation::get_ticks() {
+	return ticks;
+}
+
+double Simulation::get_time() {
+	return time;
+}
+
+double Simulation::get_render_time() {
+	return time - last_step + accumulator;
+}
+
+float Simulation::get_alpha() {
+	return (float) (accumulator / last_step);
+}
+
+float Simulation::get_step_size() {
+	return step_size;
+}
+
+int Simulation::get_max_steps() {
+	return max_steps;
+}
+
+IntegratorType Simulation::get_integrator_type() {
+	return integrator_type;
+}
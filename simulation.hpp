@@ -0,0 +1,83 @@
+#ifndef SIMULATION_HPP
+#define SIMULATION_HPP
+
+#include <glm/glm.hpp>
+
+#include "integrator.hpp"
+#include "planet.hpp"
+#include "player.hpp"
+
+//First touchdown of the ship, found inside the step
+struct Contact {
+	double time;
+	BodyState state; //Of the ship
+	glm::dvec3 planet_position;
+};
+
+/*
+Fixed timestep stepper.
+The frame time is accumulated and consumed in steps of `step_size`, so the physics does not depend on the frame rate.
+After `advance()` the planet and the player are placed between the last two states for rendering.
+
+Time warp multiplies the frame time. The steps grow by powers of two, as far as they stay small against the orbit around the planet,
+so that a warped frame takes few of them and never more than a bound; past that the ship coasts on its Kepler orbit when that is accurate,
+otherwise the surplus time is dropped.
+*/
+class Simulation {
+public:
+	Simulation(
+		Planet *planet, Player *player,
+		IntegratorType integrator_type=IntegratorType::VELOCITY_VERLET,
+		float step_size=1.0f/240, int max_steps=16
+	);
+	~Simulation();
+
+	void advance(float frame_time);
+
+	void set_warp(float warp);
+	float get_warp();
+	bool is_coasting(); //The last frame went on rails
+
+	bool has_contact();
+	const Contact &get_contact();
+	void clear_contact(); //Looks for the next one
+
+	long long get_ticks(); //Steps taken
+	double get_time(); //Time of the latest state
+	double get_render_time(); //Time the frame shows, between the last two states
+	float get_alpha(); //[0, 1), interpolation factor between the last two states
+	float get_step_size(); //Base step
+	int get_max_steps();
+	IntegratorType get_integrator_type();
+
+private:
+	void step(float step);
+	void detect_contact(const BodyState &start, float step); //Of the step from `start`, at `time`
+	BodyState get_planet_state(double time);
+	float get_warp_step(int steps, bool accurate); //Power-of-two multiple of `step_size` that fits the accumulator in `steps`; optionally grown or cut to `get_max_step()`
+	float get_max_step(); //Largest accurate step for the ship
+	bool coast(); //Consumes the whole accumulator on rails. false if the ship's orbit doesn't allow it.
+
+	Planet *planet;
+	Player *player;
+	Integrator *integrator;
+	IntegratorType integrator_type;
+
+	float step_size;
+	int max_steps; //Per `advance()`. Surplus time is dropped when the renderer stalls.
+
+	long long ticks;
+	double time;
+	double accumulator;
+	float last_step;
+
+	float warp;
+	bool coasting;
+
+	bool contact_found;
+	Contact contact;
+	double planet_state_time; //Last `get_planet_state()`, as the end of a step is the start of the next
+	BodyState planet_state;
+};
+
+#endif
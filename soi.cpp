@@ -0,0 +1,224 @@
+#include "soi.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//Of a point mass at `source`
+static glm::dvec3 pull(glm::dvec3 source, float gm, glm::dvec3 target) {
+	glm::dvec3 diff = source - target;
+	double dist2 = glm::dot(diff, diff);
+	return diff * (gm / (dist2 * std::sqrt(dist2)));
+}
+
+SoiSystem::SoiSystem(float root_gm) {
+	Body root;
+	root.parent = -1;
+	root.gm = root_gm;
+	root.rails_gm = 0.0f;
+	root.orbit = {};
+	root.basis = {};
+	root.soi_radius = std::numeric_limits<float>::infinity();
+	root.max_child_speed = 0.0f;
+	bodies.push_back(root);
+
+	placed_time = 0.0;
+	placed = false;
+}
+
+int SoiSystem::add_body(int parent, float gm, const OrbitalElements &orbit) {
+	Body body;
+	body.parent = parent;
+	body.gm = gm;
+	body.rails_gm = orbit.mean_motion * orbit.mean_motion * orbit.semi_major_axis * orbit.semi_major_axis * orbit.semi_major_axis;
+	body.orbit = orbit;
+	body.basis = get_orbit_basis(orbit);
+	body.soi_radius = orbit.semi_major_axis * std::pow(gm / bodies[parent].gm, 0.4f);
+	body.max_child_speed = 0.0f;
+
+	float e = orbit.eccentricity;
+	float periapsis_speed = orbit.mean_motion * orbit.semi_major_axis * std::sqrt((1 + e) / (1 - e));
+	bodies[parent].max_child_speed = std::max(bodies[parent].max_child_speed, periapsis_speed);
+
+	int index = (int) bodies.size();
+	bodies.push_back(body);
+	bodies[parent].children.push_back(index);
+	placed = false;
+	return index;
+}
+
+int SoiSystem::get_count() {
+	return (int) bodies.size();
+}
+
+int SoiSystem::get_parent(int body) {
+	return bodies[body].parent;
+}
+
+float SoiSystem::get_gm(int body) {
+	return bodies[body].gm;
+}
+
+float SoiSystem::get_soi_radius(int body) {
+	return bodies[body].soi_radius;
+}
+
+float SoiSystem::get_max_child_speed(int body) {
+	return bodies[body].max_child_speed;
+}
+
+void SoiSystem::update(double time) {
+	int n = (int) bodies.size();
+	positions.resize(n);
+	velocities.resize(n);
+	accelerations.resize(n);
+	positions[0] = velocities[0] = accelerations[0] = glm::dvec3(0.0);
+
+	//Parents come before their children
+	for (int i = 1; i < n; i++) {
+		const Body &body = bodies[i];
+		glm::dvec3 position, velocity;
+		propagate_orbit(body.orbit, body.basis, time, &position, &velocity);
+
+		positions[i] = positions[body.parent] + position;
+		velocities[i] = velocities[body.parent] + velocity;
+		accelerations[i] = accelerations[body.parent] + pull(glm::dvec3(0.0), body.rails_gm, position);
+	}
+
+	placed_time = time;
+	placed = true;
+}
+
+void SoiSystem::get_body_state(int body, double time, glm::dvec3 *position, glm::dvec3 *velocity, glm::dvec3 *acceleration) {
+	if (placed && time == placed_time) {
+		*position = positions[body];
+		*velocity = velocities[body];
+		*acceleration = accelerations[body];
+		return;
+	}
+
+	*position = *velocity = *acceleration = glm::dvec3(0.0);
+	for (int i = body; bodies[i].parent >= 0; i = bodies[i].parent) {
+		glm::dvec3 p, v;
+		propagate_orbit(bodies[i].orbit, bodies[i].basis, time, &p, &v);
+		*position += p;
+		*velocity += v;
+		*acceleration += pull(glm::dvec3(0.0), bodies[i].rails_gm, p);
+	}
+}
+
+int SoiSystem::find_child(int body, glm::dvec3 position, double time, float *margin) {
+	*margin = std::numeric_limits<float>::infinity();
+	for (int child : bodies[body].children) {
+		glm::dvec3 p, v, a;
+		get_body_state(child, time, &p, &v, &a);
+		float dist = (float) glm::length(position - p) - bodies[child].soi_radius;
+		if (dist < 0.0f)
+			return child;
+		*margin = std::min(*margin, dist);
+	}
+	return -1;
+}
+
+int SoiSystem::find_dominant(glm::dvec3 position, double time, int body) {
+	glm::dvec3 p, v, a;
+	while (bodies[body].parent >= 0) {
+		get_body_state(body, time, &p, &v, &a);
+		if (glm::length(position - p) <= bodies[body].soi_radius)
+			break;
+		body = bodies[body].parent;
+	}
+
+	float margin;
+	for (int child = find_child(body, position, time, &margin); child >= 0; child = find_child(body, position, time, &margin))
+		body = child;
+	return body;
+}
+
+glm::dvec3 SoiSystem::get_gravity(int body, glm::dvec3 target, double time, bool perturbations) {
+	//The pull of the body in its frame, which moves with the rails' acceleration
+	glm::dvec3 position, velocity, acceleration;
+	get_body_state(body, time, &position, &velocity, &acceleration);
+	glm::dvec3 accel = acceleration + pull(position, bodies[body].gm, target);
+	if (!perturbations)
+		return accel;
+
+	//Tide of the parent: its pull on the ship, less the one on the body
+	int parent = bodies[body].parent;
+	if (parent >= 0) {
+		glm::dvec3 p, v, a;
+		get_body_state(parent, time, &p, &v, &a);
+		accel += pull(p, bodies[parent].gm, target) - pull(p, bodies[parent].gm, position);
+	}
+
+	//The children are on rails and don't move the body
+	for (int child : bodies[body].children) {
+		glm::dvec3 p, v, a;
+		get_body_state(child, time, &p, &v, &a);
+		accel += pull(p, bodies[child].gm, target);
+	}
+	return accel;
+}
+
+SoiField::SoiField(SoiSystem *system, int body)
+	: system(system), body(body), perturbations(false)
+{
+	margin = -1.0f; //Scans on the first update
+	last_time = 0.0;
+}
+
+glm::dvec3 SoiField::get_gravity(glm::dvec3 target, double time) {
+	return system->get_gravity(body, target, time, perturbations);
+}
+
+void SoiField::rescan(glm::dvec3 position, double time) {
+	int child = system->find_child(body, position, time, &margin);
+	if (child >= 0) {
+		int next = system->find_dominant(position, time, child);
+		events.push_back({time, body, next});
+		body = next;
+		system->find_child(body, position, time, &margin);
+	}
+}
+
+bool SoiField::update(const BodyState &state, double time) {
+	size_t event_count = events.size();
+
+	glm::dvec3 position, velocity, acceleration;
+	system->get_body_state(body, time, &position, &velocity, &acceleration);
+	if (glm::length(state.position - position) > system->get_soi_radius(body)) {
+		//Out; wherever it went, the new body's children get scanned
+		int next = system->find_dominant(state.position, time, body);
+		events.push_back({time, body, next});
+		body = next;
+		system->find_child(body, state.position, time, &margin);
+	}
+	else {
+		//Closing on the children at most at both speeds, to first order over the step
+		float speed = (float) glm::length(state.velocity - velocity) + system->get_max_child_speed(body);
+		margin -= speed * (float) std::abs(time - last_time);
+		if (margin <= 0.0f)
+			rescan(state.position, time);
+	}
+
+	last_time = time;
+	return events.size() > event_count;
+}
+
+int SoiField::get_body() {
+	return body;
+}
+
+void SoiField::set_perturbations(bool perturbations) {
+	this->perturbations = perturbations;
+}
+
+const std::vector<SoiEvent> &SoiField::get_events() {
+	return events;
+}
+
+void SoiField::clear_events() {
+	events.clear();
+}
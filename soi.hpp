@@ -0,0 +1,92 @@
+#ifndef SOI_HPP
+#define SOI_HPP
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "integrator.hpp"
+#include "kepler.hpp"
+
+//A ship leaving the sphere of influence of `from` for the one of `to`
+struct SoiEvent {
+	double time;
+	int from, to; //Bodies
+};
+
+/*
+Bodies on rails in a hierarchy: a fixed root at the origin, each other body on an orbit around its parent.
+Each body pulls inside its sphere of influence, a * (gm / parent gm)^(2/5) (Laplace), and nowhere else:
+a ship only feels its dominant body, in the body's frame (patched conics), so its cost doesn't grow with the number of bodies.
+Read-only between `update()`s, so any thread can query.
+*/
+class SoiSystem {
+public:
+	SoiSystem(float root_gm);
+
+	int add_body(int parent, float gm, const OrbitalElements &orbit); //Parents come first. Returns the index; the root is 0.
+	int get_count();
+	int get_parent(int body); //-1 for the root
+	float get_gm(int body);
+	float get_soi_radius(int body); //Infinite for the root
+
+	void update(double time); //Places every body; queries at `time` read the placement, others walk up the parents
+	void get_body_state(int body, double time, glm::dvec3 *position, glm::dvec3 *velocity, glm::dvec3 *acceleration); //Absolute; the acceleration is the one of its rails
+
+	int find_dominant(glm::dvec3 position, double time, int body=0); //From `body`: out while outside its sphere, then into the children it's in
+	int find_child(int body, glm::dvec3 position, double time, float *margin); //Child whose sphere holds `position`, or -1. `margin`: closest distance to the spheres.
+	float get_max_child_speed(int body); //Fastest child around `body`, at its periapsis
+
+	//Acceleration at `target` with `body` dominant. `perturbations`: adds the tide of the parent and the pulls of the children.
+	glm::dvec3 get_gravity(int body, glm::dvec3 target, double time, bool perturbations);
+
+private:
+	struct Body {
+		int parent;
+		float gm;
+		float rails_gm; //n^2 a^3 of its orbit, which may not match the parent's gm
+		OrbitalElements orbit;
+		OrbitBasis basis;
+		float soi_radius;
+		float max_child_speed;
+		std::vector<int> children;
+	};
+
+	std::vector<Body> bodies;
+
+	double placed_time;
+	bool placed;
+	std::vector<glm::dvec3> positions, velocities, accelerations; //Of the placement
+};
+
+/*
+A ship's view of a `SoiSystem`: the field of its dominant body, kept up to date by `update()` after each step.
+The children are only scanned again once the ship could have closed the margin to their spheres.
+*/
+class SoiField : public GravityField {
+public:
+	SoiField(SoiSystem *system, int body=0);
+
+	glm::dvec3 get_gravity(glm::dvec3 target, double time) override;
+
+	bool update(const BodyState &state, double time); //true on a transition, which is logged
+	int get_body();
+	void set_perturbations(bool perturbations); //Off by default
+
+	const std::vector<SoiEvent> &get_events();
+	void clear_events();
+
+private:
+	void rescan(glm::dvec3 position, double time);
+
+	SoiSystem *system;
+	int body;
+	bool perturbations;
+
+	float margin; //To the children's spheres, as of the last scan, less what the ship may have closed since
+	double last_time;
+
+	std::vector<SoiEvent> events;
+};
+
+#endif
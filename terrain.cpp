@@ -0,0 +1,327 @@
+#include "terrain.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include <stb_image.h>
+
+#include "utils.hpp"
+
+//Cube faces: +X, -X, +Y, -Y, +Z, -Z. A direction d on face f is N + u U + v V (scaled), with u, v in [-1, 1].
+static const glm::vec3 FACE_N[6] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+static const glm::vec3 FACE_U[6] = {{0, 0, -1}, {0, 0, 1}, {1, 0, 0}, {1, 0, 0}, {1, 0, 0}, {-1, 0, 0}};
+static const glm::vec3 FACE_V[6] = {{0, 1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}, {0, 1, 0}, {0, 1, 0}};
+
+glm::vec3 get_cube_point(int face, float u, float v) {
+	return FACE_N[face] + u * FACE_U[face] + v * FACE_V[face];
+}
+
+const float UV_PER_RADIAN = 4.25f; //Upper bound of how fast u, v move with the angle (at the corners of a face)
+const float EDGE_TOLERANCE = 1e-4f; //Barycentric; so shared edges leave no cracks
+
+static int get_face(glm::vec3 d, float *u, float *v) {
+	glm::vec3 a = glm::abs(d);
+	int face;
+	if (a.x >= a.y && a.x >= a.z)
+		face = d.x > 0 ? 0 : 1;
+	else if (a.y >= a.z)
+		face = d.y > 0 ? 2 : 3;
+	else
+		face = d.z > 0 ? 4 : 5;
+
+	float n = glm::dot(d, FACE_N[face]);
+	*u = glm::dot(d, FACE_U[face]) / n;
+	*v = glm::dot(d, FACE_V[face]) / n;
+	return face;
+}
+
+//Triangles of an OBJ file, 3 positions and UVs each. Polygons are split into fans.
+static bool load_mesh(const char *path, std::vector<glm::vec3> *positions, std::vector<glm::vec2> *uvs) {
+	std::ifstream file(path);
+	if (!file) {
+		std::cout << "Failed to open the mesh: " << path << std::endl;
+		return false;
+	}
+
+	std::vector<glm::vec3> vertices;
+	std::vector<glm::vec2> texcoords;
+	std::string line;
+	while (std::getline(file, line)) {
+		std::istringstream in(line);
+		std::string type;
+		in >> type;
+
+		if (type == "v") {
+			glm::vec3 p;
+			in >> p.x >> p.y >> p.z;
+			vertices.push_back(p);
+		}
+		else if (type == "vt") {
+			glm::vec2 t;
+			in >> t.x >> t.y;
+			texcoords.push_back(t);
+		}
+		else if (type == "f") {
+			//v/vt[/vn]
+			std::vector<int> vi, ti;
+			std::string corner;
+			while (in >> corner) {
+				int v = 0, t = 0;
+				if (std::sscanf(corner.c_str(), "%d/%d", &v, &t) != 2)
+					return false;
+				vi.push_back(v - 1);
+				ti.push_back(t - 1);
+			}
+
+			for (size_t i = 2; i < vi.size(); i++) {
+				int corners[3] = {0, (int) i - 1, (int) i};
+				for (int c : corners) {
+					if (vi[c] < 0 || vi[c] >= (int) vertices.size() || ti[c] < 0 || ti[c] >= (int) texcoords.size())
+						return false;
+					positions->push_back(vertices[vi[c]]);
+					uvs->push_back(texcoords[ti[c]]);
+				}
+			}
+		}
+	}
+	return !positions->empty();
+}
+
+//Bilinear, wrapping around horizontally. `Model` flips the UVs, so v = 1 is the top row.
+static float sample_bump(const unsigned char *bump, int width, int height, glm::vec2 uv) {
+	float x = uv.x * width - 0.5f;
+	float y = (1 - uv.y) * height - 0.5f;
+	float fx = std::floor(x), fy = std::floor(y);
+	float tx = x - fx, ty = y - fy;
+
+	int x0 = ((int) fx % width + width) % width;
+	int x1 = (x0 + 1) % width;
+	int y0 = glm::clamp((int) fy, 0, height - 1);
+	int y1 = glm::clamp((int) fy + 1, 0, height - 1);
+
+	float top = glm::mix((float) bump[y0 * width + x0], (float) bump[y0 * width + x1], tx);
+	float bottom = glm::mix((float) bump[y1 * width + x0], (float) bump[y1 * width + x1], tx);
+	return glm::mix(top, bottom, ty) / 255;
+}
+
+Terrain::Terrain() {
+	resolution = 0;
+	min_height = max_height = 0.0f;
+}
+
+bool Terrain::load(const char *mesh_path, const char *bump_path, int resolution) {
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec2> uvs;
+	if (!load_mesh(mesh_path, &positions, &uvs)) {
+		std::cout << "Failed to load the mesh: " << mesh_path << std::endl;
+		return false;
+	}
+
+	int width, height, components;
+	unsigned char *bump = stbi_load(bump_path, &width, &height, &components, 1);
+	if (bump == nullptr) {
+		std::cout << "Failed to load the bump map: " << bump_path << std::endl;
+		return false;
+	}
+
+	this->resolution = resolution;
+	for (int f = 0; f < 6; f++)
+		heights[f].assign(resolution * resolution, -1.0f);
+
+	/*
+	Each triangle claims the texels of the faces in front of it whose rays hit it,
+	with the bump map at the UV interpolated there, as the GPU does.
+	*/
+	for (size_t t = 0; t < positions.size(); t += 3) {
+		glm::vec3 p0 = positions[t], e1 = positions[t + 1] - p0, e2 = positions[t + 2] - p0;
+
+		for (int f = 0; f < 6; f++) {
+			float u_min = 1, u_max = -1, v_min = 1, v_max = -1;
+			bool in_front = true;
+			for (int c = 0; c < 3; c++) {
+				float n = glm::dot(positions[t + c], FACE_N[f]);
+				if (n <= 0.1f) {
+					in_front = false;
+					break;
+				}
+				float u = glm::dot(positions[t + c], FACE_U[f]) / n;
+				float v = glm::dot(positions[t + c], FACE_V[f]) / n;
+				u_min = std::min(u_min, u); u_max = std::max(u_max, u);
+				v_min = std::min(v_min, v); v_max = std::max(v_max, v);
+			}
+			if (!in_front || u_min > 1 || u_max < -1 || v_min > 1 || v_max < -1)
+				continue;
+
+			int x0 = std::max(0, (int) std::floor((u_min + 1) * 0.5f * resolution - 0.5f));
+			int x1 = std::min(resolution - 1, (int) std::ceil((u_max + 1) * 0.5f * resolution - 0.5f));
+			int y0 = std::max(0, (int) std::floor((v_min + 1) * 0.5f * resolution - 0.5f));
+			int y1 = std::min(resolution - 1, (int) std::ceil((v_max + 1) * 0.5f * resolution - 0.5f));
+
+			for (int y = y0; y <= y1; y++)
+				for (int x = x0; x <= x1; x++) {
+					float u = (x + 0.5f) / resolution * 2 - 1;
+					float v = (y + 0.5f) / resolution * 2 - 1;
+					glm::vec3 ray = get_cube_point(f, u, v);
+
+					//Moller-Trumbore, from the center
+					glm::vec3 pvec = glm::cross(ray, e2);
+					float det = glm::dot(e1, pvec);
+					if (std::fabs(det) < 1e-12f)
+						continue;
+					glm::vec3 tvec = -p0;
+					float b1 = glm::dot(tvec, pvec) / det;
+					glm::vec3 qvec = glm::cross(tvec, e1);
+					float b2 = glm::dot(ray, qvec) / det;
+					if (b1 < -EDGE_TOLERANCE || b2 < -EDGE_TOLERANCE || b1 + b2 > 1 + EDGE_TOLERANCE || glm::dot(e2, qvec) / det <= 0)
+						continue;
+
+					glm::vec2 uv = uvs[t] * (1 - b1 - b2) + uvs[t + 1] * b1 + uvs[t + 2] * b2;
+					heights[f][y * resolution + x] = sample_bump(bump, width, height, uv);
+				}
+		}
+	}
+	stbi_image_free(bump);
+
+	//Texels no triangle claimed (if the mesh has holes) take the mean of their claimed neighbours
+	for (int f = 0; f < 6; f++) {
+		std::vector<float> &face = heights[f];
+		for (bool filled = true; filled; ) {
+			filled = false;
+			std::vector<float> next = face;
+			for (int y = 0; y < resolution; y++)
+				for (int x = 0; x < resolution; x++) {
+					if (face[y * resolution + x] >= 0)
+						continue;
+					float sum = 0;
+					int count = 0;
+					const int OFFSETS[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+					for (const int *o : OFFSETS) {
+						int nx = x + o[0], ny = y + o[1];
+						if (nx >= 0 && nx < resolution && ny >= 0 && ny < resolution && face[ny * resolution + nx] >= 0) {
+							sum += face[ny * resolution + nx];
+							count++;
+						}
+					}
+					if (count > 0) {
+						next[y * resolution + x] = sum / count;
+						filled = true;
+					}
+				}
+			face.swap(next);
+		}
+		std::replace_if(face.begin(), face.end(), [](float h) {return h < 0;}, 0.5f); //A face with no triangle at all
+	}
+
+	build_tiles();
+	return true;
+}
+
+void Terrain::build_tiles() {
+	min_height = 1.0f;
+	max_height = 0.0f;
+
+	for (int f = 0; f < 6; f++) {
+		tiles[f].clear();
+		const float *below_min = heights[f].data(), *below_max = heights[f].data();
+		int below_size = resolution;
+
+		for (int size = resolution / 2; size >= 1; size /= 2) {
+			tiles[f].push_back(Tiles());
+			Tiles &level = tiles[f].back();
+			level.size = size;
+			level.min.resize(size * size);
+			level.max.resize(size * size);
+
+			for (int y = 0; y < size; y++)
+				for (int x = 0; x < size; x++) {
+					int i = (2*y) * below_size + 2*x;
+					level.min[y * size + x] = std::min(
+						std::min(below_min[i], below_min[i + 1]), std::min(below_min[i + below_size], below_min[i + below_size + 1]));
+					level.max[y * size + x] = std::max(
+						std::max(below_max[i], below_max[i + 1]), std::max(below_max[i + below_size], below_max[i + below_size + 1]));
+				}
+
+			below_min = level.min.data();
+			below_max = level.max.data();
+			below_size = size;
+		}
+
+		min_height = std::min(min_height, tiles[f].back().min[0]);
+		max_height = std::max(max_height, tiles[f].back().max[0]);
+	}
+}
+
+bool Terrain::is_loaded() {
+	return resolution > 0;
+}
+
+float Terrain::get_texel_angle() {
+	return (PI / 2) / resolution;
+}
+
+float Terrain::get_height(glm::vec3 direction) {
+	float u, v;
+	int f = get_face(direction, &u, &v);
+
+	float x = glm::clamp((u + 1) * 0.5f * resolution - 0.5f, 0.0f, resolution - 1.0f);
+	float y = glm::clamp((v + 1) * 0.5f * resolution - 0.5f, 0.0f, resolution - 1.0f);
+	int ix = std::min((int) x, resolution - 2);
+	int iy = std::min((int) y, resolution - 2);
+	float tx = x - ix, ty = y - iy;
+
+	const float *row = heights[f].data() + iy * resolution + ix;
+	float bottom = glm::mix(row[0], row[1], tx);
+	float top = glm::mix(row[resolution], row[resolution + 1], tx);
+	return glm::mix(bottom, top, ty);
+}
+
+void Terrain::get_height_range(glm::vec3 direction, float angle, float *min, float *max) {
+	*min = min_height;
+	*max = max_height;
+
+	float u, v;
+	int f = get_face(direction, &u, &v);
+	float r = angle * UV_PER_RADIAN;
+	if (u - r < -1 || u + r > 1 || v - r < -1 || v + r > 1)
+		return; //Across an edge of the face; the global bounds will do
+
+	//Texels the bilinear samples in the range read
+	int x0 = std::max(0, (int) std::floor((u - r + 1) * 0.5f * resolution - 0.5f));
+	int x1 = std::min(resolution - 1, (int) std::floor((u + r + 1) * 0.5f * resolution - 0.5f) + 1);
+	int y0 = std::max(0, (int) std::floor((v - r + 1) * 0.5f * resolution - 0.5f));
+	int y1 = std::min(resolution - 1, (int) std::floor((v + r + 1) * 0.5f * resolution - 0.5f) + 1);
+
+	//The finest level where they fit in 2x2 tiles
+	int level = 0;
+	while ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)
+		level++;
+
+	const float *mins, *maxs;
+	int size;
+	if (level == 0) {
+		mins = maxs = heights[f].data();
+		size = resolution;
+	}
+	else {
+		if (level > (int) tiles[f].size())
+			return;
+		const Tiles &t = tiles[f][level - 1];
+		mins = t.min.data();
+		maxs = t.max.data();
+		size = t.size;
+	}
+
+	*min = 1.0f;
+	*max = 0.0f;
+	for (int y = y0 >> level; y <= y1 >> level; y++)
+		for (int x = x0 >> level; x <= x1 >> level; x++) {
+			*min = std::min(*min, mins[y * size + x]);
+			*max = std::max(*max, maxs[y * size + x]);
+		}
+}
@@ -0,0 +1,48 @@
+#ifndef TERRAIN_HPP
+#define TERRAIN_HPP
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+const char *const MARS_MESH_PATH = "resources/mars/mars.obj";
+const char *const MARS_BUMP_PATH = "resources/mars/mars_bump.png";
+const float MARS_RELIEF = 0.009f; //Full range of the bump map over the radius: ~30 km on 3390 km
+
+//Point of the cube [-1, 1]^3 at `u`, `v` in [-1, 1] on `face` (+X, -X, +Y, -Y, +Z, -Z); normalized, the direction it stands for.
+//The faces of `Terrain` and `ChunkedTerrain`.
+glm::vec3 get_cube_point(int face, float u, float v);
+
+/*
+Relief of a planet: height in [0, 1] by direction from its center, in the planet's own (unrotated) frame.
+Built once from a bump map wrapped on the planet's mesh by its UVs, as it is drawn,
+and resampled into a cube-sphere: 6 faces of `resolution`^2 texels, each with a pyramid of min/max tiles.
+Point queries are bilinear on one face; range queries read at most 2x2 tiles of the level that covers the range.
+Read-only after `load()`, so any thread can query.
+*/
+class Terrain {
+public:
+	Terrain();
+
+	bool load(const char *mesh_path, const char *bump_path, int resolution=512); //false if a file is missing or broken
+
+	bool is_loaded();
+	float get_texel_angle(); //Radians, at the center of a face
+	float get_height(glm::vec3 direction);
+	void get_height_range(glm::vec3 direction, float angle, float *min, float *max); //Bounds over the cap of `angle` radians around `direction`
+
+private:
+	struct Tiles {
+		int size;
+		std::vector<float> min, max; //size^2
+	};
+
+	void build_tiles();
+
+	int resolution;
+	std::vector<float> heights[6]; //resolution^2 per face
+	std::vector<Tiles> tiles[6]; //[k] covers 2^(k+1) texels a side
+	float min_height, max_height;
+};
+
+#endif
@@ -0,0 +1,72 @@
+#include "trajectory.hpp"
+
+#include <glm/glm.hpp>
+
+TrajectoryPredictor::TrajectoryPredictor(
+	GravityField *field,
+	IntegratorType integrator_type, float step_size,
+	int length, int max_steps, int stride
+)
+	: field(field), step_size(step_size),
+	length(length), max_steps(max_steps), stride(stride)
+{
+	integrator = new_integrator(integrator_type);
+	first_tick = 0;
+	resimulated = 0;
+}
+
+TrajectoryPredictor::~TrajectoryPredictor() {
+	delete integrator;
+}
+
+void TrajectoryPredictor::update(const BodyState &state, long long tick, double time) {
+	//Drop the past
+	while (!states.empty() && first_tick < tick) {
+		states.pop_front();
+		times.pop_front();
+		first_tick++;
+	}
+
+	//Still on the predicted path? Compared exactly, as the steps are the same.
+	bool on_path = !states.empty() && first_tick == tick && times.front() == time
+		&& states.front().position == state.position && states.front().velocity == state.velocity;
+	if (!on_path) {
+		states.clear();
+		times.clear();
+		states.push_back(state);
+		times.push_back(time);
+		first_tick = tick;
+	}
+
+	//Extend the tail
+	resimulated = 0;
+	while ((int) states.size() < length && resimulated < max_steps) {
+		BodyState next = states.back();
+		double next_time = times.back();
+		integrator->step(&next, next_time, step_size, field); //As `Simulation::step()`
+		states.push_back(next);
+		times.push_back(next_time + step_size);
+		resimulated++;
+	}
+
+	//Sampled on absolute ticks, so the points don't crawl along the path
+	samples.clear();
+	long long offset = (stride - first_tick % stride) % stride;
+	for (size_t i = (size_t) offset; i < states.size(); i += stride)
+		samples.push_back(states[i].position);
+}
+
+const glm::vec3 *TrajectoryPredictor::get_path(glm::dvec3 origin) {
+	path.resize(samples.size());
+	for (size_t i = 0; i < samples.size(); i++)
+		path[i] = glm::vec3(samples[i] - origin);
+	return path.data();
+}
+
+int TrajectoryPredictor::get_path_length() {
+	return (int) samples.size();
+}
+
+int TrajectoryPredictor::get_resimulated() {
+	return resimulated;
+}
@@ -0,0 +1,52 @@
+#ifndef TRAJECTORY_HPP
+#define TRAJECTORY_HPP
+
+#include <glm/glm.hpp>
+
+#include <deque>
+#include <vector>
+
+#include "integrator.hpp"
+
+/*
+Ghost path of the ship: its states for the next `length` ticks, coasting under `field`.
+The prediction is kept across frames. Each update drops the ticks that passed and only simulates the new tail,
+unless the ship left the predicted path (thrust), which invalidates everything after it.
+Steps the same way as `Simulation`, so a coasting ship follows the prediction exactly.
+Warped steps don't match the prediction and restart it.
+*/
+class TrajectoryPredictor {
+public:
+	TrajectoryPredictor(
+		GravityField *field,
+		IntegratorType integrator_type, float step_size,
+		int length=10000, int max_steps=2500, int stride=4
+	);
+	~TrajectoryPredictor();
+
+	//`state` is the ship at `tick`, `time`. Simulates at most `max_steps` ticks.
+	void update(const BodyState &state, long long tick, double time);
+
+	const glm::vec3 *get_path(glm::dvec3 origin); //Every `stride`th predicted position, relative to `origin` for drawing
+	int get_path_length();
+	int get_resimulated(); //Ticks simulated by the last update
+
+private:
+	GravityField *field;
+	Integrator *integrator;
+	float step_size;
+
+	int length;
+	int max_steps;
+	int stride;
+
+	std::deque<BodyState> states; //states[i] at tick `first_tick + i`
+	std::deque<double> times; //Of the states, summed as in `Simulation`
+	long long first_tick;
+	int resimulated;
+
+	std::vector<glm::dvec3> samples; //Of the path
+	std::vector<glm::vec3> path;
+};
+
+#endif
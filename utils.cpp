@@ -8,9 +8,17 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/string_cast.hpp>
 
+#include <learnopengl/gl_state.h>
 #include <learnopengl/shader_m.h>
 
+#include "culling.hpp"
+#include "frame.hpp"
+#include "render_queue.hpp"
+
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <cstring>
 #include <iostream>
 #include <vector>
 #include <tuple>
@@ -34,7 +42,7 @@ public:
 	Shape(int vlen, GLenum mode);
 	~Shape();
 
-	virtual void draw(glm::mat4 projection, glm::mat4 view, glm::vec3 location, float scale, glm::vec4 color);
+	virtual void draw(glm::vec3 location, float scale, glm::vec4 color);
 
 protected:
 	int get_vlen(); //# of vertices
@@ -48,28 +56,17 @@ protected:
 private:
 	GLenum mode;
 	int vlen;
+	int count; //# of vertices to draw
 
 	float *vertices;
 	unsigned int VAO, VBO;
 	Shader *shader;
+	Uniform<glm::vec4> color_uniform; //Of `shader`
+	Uniform<glm::mat4> model_uniform;
 
 	Textures *textures;
 };
 
-class Circle : public Shape {
-public:
-	Circle();
-
-	void draw(glm::mat4 projection, glm::mat4 view, glm::vec3 location, float radius, glm::vec4 color);
-};
-
-class Line : public Shape {
-public:
-	Line();
-
-	void draw(glm::mat4 projection, glm::mat4 view, glm::vec3 p, glm::vec3 q, glm::vec4 color);
-};
-
 class Cube : public Shape {
 public:
 	Cube();
@@ -80,7 +77,7 @@ public:
 	Cubemap(unsigned int texture);
 	~Cubemap();
 
-	void draw(glm::mat4 projection, glm::mat4 view);
+	void draw();
 
 	unsigned int get_texture() const;
 	bool operator==(const Cubemap &o) const;
@@ -90,52 +87,178 @@ private:
 	Textures *textures;
 };
 
-static Circle *circle = nullptr;
-static Line *line = nullptr;
-static Cube *cube = nullptr;
+//Vertex of `ShapeBatch`'s lines: 16 bytes
+struct BatchVertex {
+	glm::vec3 position;
+	unsigned char color[4]; //RGBA, normalized
+};
+
+//Per-instance data of `InstancedShape`: 20 bytes
+struct ShapeInstance {
+	glm::vec4 location_scale; //xyz: location, w: scale
+	unsigned char color[4]; //RGBA, normalized
+};
+
+/*
+One fixed mesh drawn at many places: each `add()` is an instance, and `draw()` draws them all in one `glDrawArraysInstanced`.
+Only the instances are uploaded, never the mesh again.
+*/
+class InstancedShape {
+public:
+	InstancedShape(const float *vertices, int vertex_count, GLenum mode); //`vertices`: float[vertex_count * 3]
+	~InstancedShape();
+
+	void add(glm::vec3 location, float scale, glm::vec4 color);
+	int upload(Culler *culler); //Uploads the visible instances and clears them all; returns how many are to draw
+	void draw(int count); //The caller binds the shader
+
+	unsigned int get_VAO();
+
+private:
+	GLenum mode;
+	int vertex_count;
+	float bound; //Radius of the mesh at scale 1
+	vector<ShapeInstance> instances;
+
+	unsigned int VAO, mesh_VBO, instance_VBO;
+	int capacity; //Instances of `instance_VBO`'s storage
+};
+
+//Per-orbit data of `OrbitPaths`: four RGBA32F texels, 64 bytes
+struct OrbitPath {
+	glm::vec4 focus_a; //xyz: focus, w: semi-major axis
+	glm::vec4 p_e; //xyz: towards the periapsis, w: eccentricity
+	glm::vec4 q_segments; //xyz: 90 degrees ahead, w: segments
+	glm::vec4 color;
+};
+
+/*
+Keplerian orbits drawn by the GPU: the vertex shader places each vertex from `gl_VertexID` and the elements of its orbit,
+read from a buffer texture, so only 64 bytes per orbit are uploaded and no vertices at all.
+Each orbit gets as many segments as its size on screen needs, and they all go out in one `glMultiDrawArrays`.
+*/
+class OrbitPaths {
+public:
+	OrbitPaths();
+	~OrbitPaths();
+
+	void add(glm::vec3 focus, const OrbitalElements &elements, const OrbitBasis &basis, glm::vec4 color);
+	int upload(float pixels_per_radian, Culler *culler); //Uploads the visible orbits and clears them all; returns how many are to draw
+	void draw(int count); //Binds its own shader
+
+	unsigned int get_VAO();
+	unsigned int get_texture();
+	Shader *get_shader();
+
+private:
+	vector<OrbitPath> orbits;
+	vector<GLint> firsts; //Of each orbit's line strip, in `gl_VertexID`s
+	vector<GLsizei> counts;
+
+	unsigned int VAO; //Empty
+	unsigned int TBO, texture;
+	int capacity; //Orbits of `TBO`'s storage
+	Shader *shader;
+};
+
+/*
+Debug geometry of a frame. Lines and polylines go in one vertex stream with per-vertex color;
+circles and cubes are instances of a unit ring and a unit cube; orbits are built on the GPU.
+`flush()` uploads each at once and queues it as one draw, so a thousand shapes cost about as much as one.
+The vectors keep their capacity, so a steady frame doesn't allocate.
+*/
+class ShapeBatch {
+public:
+	ShapeBatch();
+	~ShapeBatch();
+
+	void add_line(glm::vec3 p, glm::vec3 q, glm::vec4 color);
+	void add_circle(glm::vec3 location, float radius, glm::vec4 color);
+	void add_polyline(const glm::vec3 *points, int n, glm::vec4 color);
+	void add_cube(glm::vec3 location, float size, glm::vec4 color);
+	void add_orbit(glm::vec3 focus, const OrbitalElements &elements, const OrbitBasis &basis, glm::vec4 color);
+
+	void flush(float pixels_per_radian, Culler *culler, RenderQueue *queue); //Uploads what is visible, queues its draws and clears everything added since the last flush
+
+private:
+	static void draw_lines(const DrawItem &item);
+	static void draw_instances(const DrawItem &item); //`data`: the `InstancedShape`
+	static void draw_orbits(const DrawItem &item);
+
+	vector<BatchVertex> lines; //GL_LINES
+
+	unsigned int VAO, VBO;
+	int capacity; //Vertices of the VBO's storage
+	Shader *shader;
+
+	InstancedShape *rings; //Unit circle on the XZ plane
+	InstancedShape *cubes; //Corners at +-1
+	Shader *instanced_shader;
+
+	OrbitPaths *orbits;
+};
+
+static ShapeBatch *batch = nullptr;
 static Cubemap *cubemap = nullptr;
 
 float get_time() {
 	return (float) glfwGetTime();
 }
 
-void draw_circle(glm::mat4 projection, glm::mat4 view, glm::vec3 location, float radius, glm::vec4 color) {
-	if (circle == nullptr)
-		circle = new Circle();
+static ShapeBatch *get_batch() {
+	if (batch == nullptr)
+		batch = new ShapeBatch();
+	return batch;
+}
+
+void draw_circle(glm::vec3 location, float radius, glm::vec4 color) {
+	get_batch()->add_circle(location, radius, color);
+}
+
+void draw_line(glm::vec3 p, glm::vec3 q, glm::vec4 color) {
+	get_batch()->add_line(p, q, color);
+}
 
-	circle->draw(projection, view, location, radius, color);
+void draw_polyline(const glm::vec3 *points, int n, glm::vec4 color) {
+	get_batch()->add_polyline(points, n, color);
 }
 
-void draw_line(glm::mat4 projection, glm::mat4 view, glm::vec3 p, glm::vec3 q, glm::vec4 color) {
-	if (line == nullptr)
-		line = new Line();
+void draw_cube(glm::vec3 location, float size, glm::vec4 color) {
+	get_batch()->add_cube(location, size, color);
+}
 
-	line->draw(projection, view, p, q, color);
+void draw_orbit_path(glm::vec3 focus, const OrbitalElements &elements, const OrbitBasis &basis, glm::vec4 color) {
+	get_batch()->add_orbit(focus, elements, basis, color);
 }
 
-void draw_cube(glm::mat4 projection, glm::mat4 view, glm::vec3 location, float size, glm::vec4 color) {
-	if (cube == nullptr)
-		cube = new Cube();
+void flush_shapes(float pixels_per_radian, Culler *culler, RenderQueue *queue) {
+	if (batch != nullptr)
+		batch->flush(pixels_per_radian, culler, queue);
+}
 
-	cube->draw(projection, view, location, size, color);
+static void draw_sky(const DrawItem &item) {
+	((Cubemap *) item.owner)->draw();
 }
 
-void draw_cubemap(glm::mat4 projection, glm::mat4 view, unsigned int cubemap_texture) {
+void draw_cubemap(unsigned int cubemap_texture, RenderQueue *queue) {
 	if (cubemap != nullptr && cubemap->get_texture() != cubemap_texture)
 		cubemap = nullptr;
 	if (cubemap == nullptr)
 		cubemap = new Cubemap(cubemap_texture);
 
-	cubemap->draw(projection, view);
+	DrawItem item;
+	item.key = RenderQueue::make_key(PASS_SKY, 0, cubemap_texture, 0.0f, 0);
+	item.draw = draw_sky;
+	item.owner = cubemap;
+	item.data = nullptr;
+	item.model = glm::mat4(1.0f);
+	item.count = 0;
+	queue->add(item);
 }
 
 void utils_cleanup() {
-	if (circle != nullptr)
-		delete circle;
-	if (line != nullptr)
-		delete line;
-	if (cube != nullptr)
-		delete cube;
+	if (batch != nullptr)
+		delete batch;
 	if (cubemap != nullptr)
 		delete cubemap;
 }
@@ -151,8 +274,8 @@ void Textures::add_texture(unsigned int texture, GLenum target) {
 void Textures::use() {
 	int i = 0;
 	for (auto &tex_and_mode : *textures) {
-		glActiveTexture(GL_TEXTURE0 + (i++));
-		glBindTexture(get<1>(tex_and_mode), get<0>(tex_and_mode));
+		GLState::activeTexture(GL_TEXTURE0 + (i++));
+		GLState::bindTexture(get<1>(tex_and_mode), get<0>(tex_and_mode));
 	}
 }
 
@@ -160,13 +283,387 @@ Textures::~Textures() {
 	delete textures;
 }
 
-Shape::Shape(int vlen, GLenum mode) : vlen(vlen), mode(mode) {
+//Two triangles per face, corners at +-1
+static const float CUBE_VERTICES[36 * 3] = {
+	-1.0f,  1.0f, -1.0f,
+	-1.0f, -1.0f, -1.0f,
+	1.0f, -1.0f, -1.0f,
+	1.0f, -1.0f, -1.0f,
+	1.0f,  1.0f, -1.0f,
+	-1.0f,  1.0f, -1.0f,
+
+	-1.0f, -1.0f,  1.0f,
+	-1.0f, -1.0f, -1.0f,
+	-1.0f,  1.0f, -1.0f,
+	-1.0f,  1.0f, -1.0f,
+	-1.0f,  1.0f,  1.0f,
+	-1.0f, -1.0f,  1.0f,
+
+	1.0f, -1.0f, -1.0f,
+	1.0f, -1.0f,  1.0f,
+	1.0f,  1.0f,  1.0f,
+	1.0f,  1.0f,  1.0f,
+	1.0f,  1.0f, -1.0f,
+	1.0f, -1.0f, -1.0f,
+
+	-1.0f, -1.0f,  1.0f,
+	-1.0f,  1.0f,  1.0f,
+	1.0f,  1.0f,  1.0f,
+	1.0f,  1.0f,  1.0f,
+	1.0f, -1.0f,  1.0f,
+	-1.0f, -1.0f,  1.0f,
+
+	-1.0f,  1.0f, -1.0f,
+	1.0f,  1.0f, -1.0f,
+	1.0f,  1.0f,  1.0f,
+	1.0f,  1.0f,  1.0f,
+	-1.0f,  1.0f,  1.0f,
+	-1.0f,  1.0f, -1.0f,
+
+	-1.0f, -1.0f, -1.0f,
+	-1.0f, -1.0f,  1.0f,
+	1.0f, -1.0f, -1.0f,
+	1.0f, -1.0f, -1.0f,
+	-1.0f, -1.0f,  1.0f,
+	1.0f, -1.0f,  1.0f
+};
+
+static void pack_color(glm::vec4 color, unsigned char *packed) {
+	for (int i = 0; i < 4; i++)
+		packed[i] = (unsigned char) (glm::clamp(color[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+static BatchVertex make_vertex(glm::vec3 position, glm::vec4 color) {
+	BatchVertex vertex;
+	vertex.position = position;
+	pack_color(color, vertex.color);
+	return vertex;
+}
+
+//Into orphaned storage, so the upload doesn't wait for the last frame's draws; the storage grows to fit
+static void upload_stream(unsigned int VBO, int *capacity, const void *data, int count, size_t stride) {
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	while (*capacity < count)
+		*capacity *= 2;
+	glBufferData(GL_ARRAY_BUFFER, *capacity * stride, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, count * stride, data);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+InstancedShape::InstancedShape(const float *vertices, int vertex_count, GLenum mode)
+	: mode(mode), vertex_count(vertex_count)
+{
+	bound = 0.0f;
+	for (int i = 0; i < vertex_count; i++)
+		bound = std::max(bound, glm::length(glm::vec3(vertices[i*3 + 0], vertices[i*3 + 1], vertices[i*3 + 2])));
+
+	glGenVertexArrays(1, &VAO);
+	GLState::bindVertexArray(VAO);
+
+	glGenBuffers(1, &mesh_VBO);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh_VBO);
+	glBufferData(GL_ARRAY_BUFFER, vertex_count * 3 * sizeof (float), vertices, GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof (float), (void *) 0);
+	glEnableVertexAttribArray(0);
+
+	capacity = 256;
+	glGenBuffers(1, &instance_VBO);
+	glBindBuffer(GL_ARRAY_BUFFER, instance_VBO);
+	glBufferData(GL_ARRAY_BUFFER, capacity * sizeof (ShapeInstance), nullptr, GL_STREAM_DRAW);
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof (ShapeInstance), (void *) offsetof(ShapeInstance, location_scale));
+	glEnableVertexAttribArray(1);
+	glVertexAttribDivisor(1, 1);
+	glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof (ShapeInstance), (void *) offsetof(ShapeInstance, color));
+	glEnableVertexAttribArray(2);
+	glVertexAttribDivisor(2, 1);
+
+	//Unbind
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLState::bindVertexArray(0);
+}
+
+void InstancedShape::add(glm::vec3 location, float scale, glm::vec4 color) {
+	ShapeInstance instance;
+	instance.location_scale = glm::vec4(location, scale);
+	pack_color(color, instance.color);
+	instances.push_back(instance);
+}
+
+int InstancedShape::upload(Culler *culler) {
+	//Keep the visible instances, in place
+	int count = 0;
+	for (const ShapeInstance &instance : instances) {
+		if (culler->is_visible(CULL_SHAPES, glm::vec3(instance.location_scale), instance.location_scale.w * bound))
+			instances[count++] = instance;
+	}
+	if (count > 0)
+		upload_stream(instance_VBO, &capacity, instances.data(), count, sizeof (ShapeInstance));
+
+	instances.clear();
+	return count;
+}
+
+void InstancedShape::draw(int count) {
+	GLState::bindVertexArray(VAO);
+	glDrawArraysInstanced(mode, 0, vertex_count, count);
+}
+
+unsigned int InstancedShape::get_VAO() {
+	return VAO;
+}
+
+InstancedShape::~InstancedShape() {
+	GLState::deleteVertexArray(VAO);
+	glDeleteBuffers(1, &mesh_VBO);
+	glDeleteBuffers(1, &instance_VBO);
+}
+
+//Vertices of an orbit's line strip: the segments, plus one to close it
+const int MIN_ORBIT_SEGMENTS = 16;
+const int MAX_ORBIT_SEGMENTS = 1024;
+const int ORBIT_STRIDE = MAX_ORBIT_SEGMENTS + 1; //`gl_VertexID`s per orbit
+
+OrbitPaths::OrbitPaths() {
+	glGenVertexArrays(1, &VAO);
+
+	capacity = 64;
+	glGenBuffers(1, &TBO);
+	glBindBuffer(GL_TEXTURE_BUFFER, TBO);
+	glBufferData(GL_TEXTURE_BUFFER, capacity * sizeof (OrbitPath), nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	glGenTextures(1, &texture);
+	GLState::bindTexture(GL_TEXTURE_BUFFER, texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, TBO);
+	GLState::bindTexture(GL_TEXTURE_BUFFER, 0);
+
+	shader = new Shader("shaders/orbit.vs", "shaders/vertexcolor.fs");
+	FrameUniforms::bind(shader);
+	shader->use();
+	shader->setInt("orbits", 0);
+	shader->setInt("stride", ORBIT_STRIDE);
+}
+
+void OrbitPaths::add(glm::vec3 focus, const OrbitalElements &elements, const OrbitBasis &basis, glm::vec4 color) {
+	OrbitPath orbit;
+	orbit.focus_a = glm::vec4(focus, elements.semi_major_axis);
+	orbit.p_e = glm::vec4(basis.p, elements.eccentricity);
+	orbit.q_segments = glm::vec4(basis.q, 0.0f); //Set at the flush
+	orbit.color = color;
+	orbits.push_back(orbit);
+}
+
+int OrbitPaths::upload(float pixels_per_radian, Culler *culler) {
+	//Keep the visible orbits, in place; the apoapsis bounds an orbit around its focus
+	int count = 0;
+	for (const OrbitPath &orbit : orbits) {
+		float apoapsis = orbit.focus_a.w * (1 + orbit.p_e.w);
+		if (culler->is_visible(CULL_SHAPES, glm::vec3(orbit.focus_a), apoapsis))
+			orbits[count++] = orbit;
+	}
+	if (count == 0) {
+		orbits.clear();
+		return 0;
+	}
+
+	//A chord of n segments strays r (1 - cos(pi / n)) ~ r pi^2 / (2 n^2) from a circle of r pixels: half a pixel at n = pi sqrt(r).
+	//The camera is at the origin; r is taken where the orbit may come closest to it.
+	firsts.clear();
+	counts.clear();
+	for (int i = 0; i < count; i++) {
+		OrbitPath &orbit = orbits[i];
+		float a = orbit.focus_a.w;
+		float apoapsis = a * (1 + orbit.p_e.w);
+		float dist = std::max(glm::length(glm::vec3(orbit.focus_a)) - apoapsis, 1e-3f * a);
+		float pixels = a / dist * pixels_per_radian;
+		int segments = glm::clamp((int) (PI * std::sqrt(pixels)), MIN_ORBIT_SEGMENTS, MAX_ORBIT_SEGMENTS);
+
+		orbit.q_segments.w = (float) segments;
+		firsts.push_back(i * ORBIT_STRIDE);
+		counts.push_back(segments + 1);
+	}
+
+	glBindBuffer(GL_TEXTURE_BUFFER, TBO);
+	while (capacity < count)
+		capacity *= 2;
+	glBufferData(GL_TEXTURE_BUFFER, capacity * sizeof (OrbitPath), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_TEXTURE_BUFFER, 0, count * sizeof (OrbitPath), orbits.data());
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	orbits.clear();
+	return count;
+}
+
+void OrbitPaths::draw(int count) {
+	shader->use();
+	GLState::activeTexture(GL_TEXTURE0);
+	GLState::bindTexture(GL_TEXTURE_BUFFER, texture);
+	GLState::bindVertexArray(VAO);
+	glMultiDrawArrays(GL_LINE_STRIP, firsts.data(), counts.data(), count);
+}
+
+unsigned int OrbitPaths::get_VAO() {
+	return VAO;
+}
+
+unsigned int OrbitPaths::get_texture() {
+	return texture;
+}
+
+Shader *OrbitPaths::get_shader() {
+	return shader;
+}
+
+OrbitPaths::~OrbitPaths() {
+	delete shader;
+	GLState::deleteVertexArray(VAO);
+	GLState::deleteTexture(texture);
+	glDeleteBuffers(1, &TBO);
+}
+
+ShapeBatch::ShapeBatch() {
+	glGenVertexArrays(1, &VAO);
+	GLState::bindVertexArray(VAO);
+
+	capacity = 4096;
+	glGenBuffers(1, &VBO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, capacity * sizeof (BatchVertex), nullptr, GL_STREAM_DRAW);
+
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof (BatchVertex), (void *) offsetof(BatchVertex, position));
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof (BatchVertex), (void *) offsetof(BatchVertex, color));
+	glEnableVertexAttribArray(1);
+
+	//Unbind
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLState::bindVertexArray(0);
+
+	shader = new Shader("shaders/vertexcolor.vs", "shaders/vertexcolor.fs");
+	FrameUniforms::bind(shader);
+
+	const int CIRCLE_SEGMENTS = 360;
+	float circle_vertices[CIRCLE_SEGMENTS * 3];
+	for (int i = 0; i < CIRCLE_SEGMENTS; i++) {
+		float angle = ((float) i / CIRCLE_SEGMENTS) * 2*PI;
+		circle_vertices[i*3 + 0] = cos(angle);
+		circle_vertices[i*3 + 1] = 0.0f;
+		circle_vertices[i*3 + 2] = sin(angle);
+	}
+	rings = new InstancedShape(circle_vertices, CIRCLE_SEGMENTS, GL_LINE_LOOP);
+	cubes = new InstancedShape(CUBE_VERTICES, 36, GL_TRIANGLES);
+
+	instanced_shader = new Shader("shaders/instanced.vs", "shaders/vertexcolor.fs");
+	FrameUniforms::bind(instanced_shader);
+
+	orbits = new OrbitPaths();
+}
+
+void ShapeBatch::add_line(glm::vec3 p, glm::vec3 q, glm::vec4 color) {
+	lines.push_back(make_vertex(p, color));
+	lines.push_back(make_vertex(q, color));
+}
+
+void ShapeBatch::add_circle(glm::vec3 location, float radius, glm::vec4 color) {
+	rings->add(location, radius, color);
+}
+
+void ShapeBatch::add_polyline(const glm::vec3 *points, int n, glm::vec4 color) {
+	for (int i = 0; i + 1 < n; i++) {
+		lines.push_back(make_vertex(points[i], color));
+		lines.push_back(make_vertex(points[i + 1], color));
+	}
+}
+
+void ShapeBatch::add_cube(glm::vec3 location, float size, glm::vec4 color) {
+	cubes->add(location, size, color);
+}
+
+void ShapeBatch::add_orbit(glm::vec3 focus, const OrbitalElements &elements, const OrbitBasis &basis, glm::vec4 color) {
+	orbits->add(focus, elements, basis, color);
+}
+
+void ShapeBatch::flush(float pixels_per_radian, Culler *culler, RenderQueue *queue) {
+	//Keep the visible segments, in place
+	int count = 0;
+	for (size_t i = 0; i + 1 < lines.size(); i += 2) {
+		glm::vec3 p = lines[i].position, q = lines[i + 1].position;
+		if (culler->is_visible(CULL_SHAPES, (p + q) * 0.5f, glm::length(q - p) * 0.5f)) {
+			lines[count++] = lines[i];
+			lines[count++] = lines[i + 1];
+		}
+	}
+	if (count > 0)
+		upload_stream(VBO, &capacity, lines.data(), count, sizeof (BatchVertex));
+	lines.clear();
+
+	//One draw per kind, each with what it was uploaded
+	DrawItem item;
+	item.owner = this;
+	item.data = nullptr;
+	item.model = glm::mat4(1.0f);
+
+	if (count > 0) {
+		item.key = RenderQueue::make_key(PASS_SHAPES, shader->ID, 0, 0.0f, VAO);
+		item.draw = draw_lines;
+		item.count = count;
+		queue->add(item);
+	}
+
+	InstancedShape *instanced[2] = {rings, cubes};
+	for (InstancedShape *shape : instanced) {
+		item.count = shape->upload(culler);
+		if (item.count == 0)
+			continue;
+		item.key = RenderQueue::make_key(PASS_SHAPES, instanced_shader->ID, 0, 0.0f, shape->get_VAO());
+		item.draw = draw_instances;
+		item.data = shape;
+		queue->add(item);
+	}
+
+	item.count = orbits->upload(pixels_per_radian, culler);
+	if (item.count > 0) {
+		item.key = RenderQueue::make_key(PASS_SHAPES, orbits->get_shader()->ID, orbits->get_texture(), 0.0f, orbits->get_VAO());
+		item.draw = draw_orbits;
+		item.data = orbits;
+		queue->add(item);
+	}
+}
+
+void ShapeBatch::draw_lines(const DrawItem &item) {
+	ShapeBatch *batch = (ShapeBatch *) item.owner;
+	batch->shader->use();
+	GLState::bindVertexArray(batch->VAO);
+	glDrawArrays(GL_LINES, 0, item.count);
+}
+
+void ShapeBatch::draw_instances(const DrawItem &item) {
+	ShapeBatch *batch = (ShapeBatch *) item.owner;
+	batch->instanced_shader->use();
+	((InstancedShape *) item.data)->draw(item.count);
+}
+
+void ShapeBatch::draw_orbits(const DrawItem &item) {
+	((OrbitPaths *) item.data)->draw(item.count);
+}
+
+ShapeBatch::~ShapeBatch() {
+	delete rings;
+	delete cubes;
+	delete orbits;
+	delete shader;
+	delete instanced_shader;
+	GLState::deleteVertexArray(VAO);
+	glDeleteBuffers(1, &VBO);
+}
+
+Shape::Shape(int vlen, GLenum mode) : vlen(vlen), mode(mode), count(vlen) {
 	//glBindVertexArray(0); //Unbind
 	//glBindBuffer(GL_ARRAY_BUFFER, 0);
 
 	//Set VAO
 	glGenVertexArrays(1, &VAO);
-	glBindVertexArray(VAO);
+	GLState::bindVertexArray(VAO);
 
 	glGenBuffers(1, &VBO);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
@@ -177,10 +674,11 @@ Shape::Shape(int vlen, GLenum mode) : vlen(vlen), mode(mode) {
 
 	//Unbind
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0); //Unbind
+	GLState::bindVertexArray(0); //Unbind
 
 	//Set shader
-	shader = new Shader("shaders/monocolor.vs", "shaders/monocolor.fs");
+	shader = nullptr;
+	set_shader(new Shader("shaders/monocolor.vs", "shaders/monocolor.fs"));
 
 	//Set vertices
 	vertices = new float[vlen*3];
@@ -199,10 +697,14 @@ float *Shape::get_vertices() {
 void Shape::apply_vertices() {
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, vlen * 3 * sizeof(float), vertices, GL_STATIC_DRAW);
+	count = vlen;
 }
 
 void Shape::set_shader(Shader *shader) {
 	this->shader = shader;
+	FrameUniforms::bind(shader);
+	color_uniform = shader->getUniform<glm::vec4>("aColor");
+	model_uniform = shader->getUniform<glm::mat4>("model");
 }
 
 /*
@@ -215,120 +717,35 @@ void Shape::set_textures(Textures *textures) {
 	this->textures = textures;
 }
 
-void Shape::draw(glm::mat4 projection, glm::mat4 view, glm::vec3 location, float scale, glm::vec4 color) {
+void Shape::draw(glm::vec3 location, float scale, glm::vec4 color) {
 	shader->use();
-	shader->setVec4("aColor", color);
-
-	shader->setMat4("projection", projection);
-	shader->setMat4("view", view);
+	shader->set(color_uniform, color);
 
 	glm::mat4 model = glm::mat4(1.0f);
 	model = glm::translate(model, location);
 	model = glm::scale(model, glm::vec3(scale));
-	shader->setMat4("model", model);
+	shader->set(model_uniform, model);
 
-	glBindVertexArray(VAO);
+	GLState::bindVertexArray(VAO);
 	if (textures != nullptr) {
 		textures->use(); 
 	}
-	glDrawArrays(mode, 0, vlen);	
+	glDrawArrays(mode, 0, count);
 }
 
 Shape::~Shape() {
 	delete shader;
 	delete[] vertices;
-	glDeleteVertexArrays(1, &VAO);
+	GLState::deleteVertexArray(VAO);
     glDeleteBuffers(1, &VBO);
 }
 
-Circle::Circle() : Shape(360, GL_LINE_LOOP) {
-	int vlen = get_vlen();
-
-	//Set `vertices`
-	float *vertices = get_vertices();
-	for (int i = 0; i < vlen; i++) {
-		float angle = ((float) i / vlen) * 2*PI;
-		vertices[i*3 + 0] = cos(angle);
-		vertices[i*3 + 1] = 0.0f;
-		vertices[i*3 + 2] = sin(angle);
-	}
-	apply_vertices();
-}
-
-void Circle::draw(glm::mat4 projection, glm::mat4 view, glm::vec3 location, float radius, glm::vec4 color) {
-	Shape::draw(projection, view, location, radius, color);
-}
-
-Line::Line() : Shape(2, GL_LINES) {
-	int vlen = get_vlen();
-	float *vertices = get_vertices();
-	for (int i = 0; i < vlen*3; i++)
-		vertices[i] = 0;
-	apply_vertices();
-}
-
-void Line::draw(glm::mat4 projection, glm::mat4 view, glm::vec3 p, glm::vec3 q, glm::vec4 color) {
-	float *vertices = get_vertices();
-	vertices[0] = p.x;
-	vertices[1] = p.y;
-	vertices[2] = p.z;
-	vertices[3] = q.x;
-	vertices[4] = q.y;
-	vertices[5] = q.z;
-	apply_vertices();
-
-	Shape::draw(projection, view, glm::vec3(0), 1, color);
-}
 
 Cube::Cube() : Shape(36, GL_TRIANGLES) {
 	int vlen = get_vlen();
 	float *vertices = get_vertices();
 	
-	float new_vertices[] = {
-        // positions          
-        -1.0f,  1.0f, -1.0f,
-        -1.0f, -1.0f, -1.0f,
-         1.0f, -1.0f, -1.0f,
-         1.0f, -1.0f, -1.0f,
-         1.0f,  1.0f, -1.0f,
-        -1.0f,  1.0f, -1.0f,
-
-        -1.0f, -1.0f,  1.0f,
-        -1.0f, -1.0f, -1.0f,
-        -1.0f,  1.0f, -1.0f,
-        -1.0f,  1.0f, -1.0f,
-        -1.0f,  1.0f,  1.0f,
-        -1.0f, -1.0f,  1.0f,
-
-         1.0f, -1.0f, -1.0f,
-         1.0f, -1.0f,  1.0f,
-         1.0f,  1.0f,  1.0f,
-         1.0f,  1.0f,  1.0f,
-         1.0f,  1.0f, -1.0f,
-         1.0f, -1.0f, -1.0f,
-
-        -1.0f, -1.0f,  1.0f,
-        -1.0f,  1.0f,  1.0f,
-         1.0f,  1.0f,  1.0f,
-         1.0f,  1.0f,  1.0f,
-         1.0f, -1.0f,  1.0f,
-        -1.0f, -1.0f,  1.0f,
-
-        -1.0f,  1.0f, -1.0f,
-         1.0f,  1.0f, -1.0f,
-         1.0f,  1.0f,  1.0f,
-         1.0f,  1.0f,  1.0f,
-        -1.0f,  1.0f,  1.0f,
-        -1.0f,  1.0f, -1.0f,
-
-        -1.0f, -1.0f, -1.0f,
-        -1.0f, -1.0f,  1.0f,
-         1.0f, -1.0f, -1.0f,
-         1.0f, -1.0f, -1.0f,
-        -1.0f, -1.0f,  1.0f,
-         1.0f, -1.0f,  1.0f
-    };
-	memcpy(vertices, new_vertices, sizeof (new_vertices));
+	memcpy(vertices, CUBE_VERTICES, sizeof (CUBE_VERTICES));
 	apply_vertices();
 }
 
@@ -344,9 +761,9 @@ Cubemap::Cubemap(unsigned int texture) : Cube() {
 	this->texture = texture;
 }
 
-void Cubemap::draw(glm::mat4 projection, glm::mat4 view) {
+void Cubemap::draw() {
 	glDepthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
-	Cube::draw(projection, glm::mat3(view), glm::vec3(10, 10, 10), 1, glm::vec4(1)); //all vars except proj and view are dummy vars + remove trans.
+	Cube::draw(glm::vec3(10, 10, 10), 1, glm::vec4(1)); //dummy vars; the shader takes the camera's rotation only
 	glDepthFunc(GL_LESS); // set depth function back to default
 }
 
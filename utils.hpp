@@ -3,14 +3,24 @@
 
 #include <glm/glm.hpp>
 
+#include "kepler.hpp"
+
+class Culler;
+class RenderQueue;
+
 const float PI = 3.1415926f;
+const double PI_D = 3.14159265358979323846;
 
 float get_time();
 
-void draw_circle(glm::mat4 projection, glm::mat4 view, glm::vec3 location, float radius, glm::vec4 color=glm::vec4(0, 1, 0, 1));
-void draw_line(glm::mat4 projection, glm::mat4 view, glm::vec3 p, glm::vec3 q, glm::vec4 color=glm::vec4(0, 1, 0, 1));
-void draw_cube(glm::mat4 projection, glm::mat4 view, glm::vec3 location, float size=1.0f, glm::vec4 color=glm::vec4(0, 1, 0, 1));
-void draw_cubemap(glm::mat4 projection, glm::mat4 view, unsigned int cubemap_texture);
+//Queued, with the camera of the `Camera` block (see `FrameUniforms`), until `flush_shapes()`
+void draw_circle(glm::vec3 location, float radius, glm::vec4 color=glm::vec4(0, 1, 0, 1));
+void draw_line(glm::vec3 p, glm::vec3 q, glm::vec4 color=glm::vec4(0, 1, 0, 1));
+void draw_polyline(const glm::vec3 *points, int n, glm::vec4 color=glm::vec4(0, 1, 0, 1));
+void draw_cube(glm::vec3 location, float size=1.0f, glm::vec4 color=glm::vec4(0, 1, 0, 1));
+void draw_orbit_path(glm::vec3 focus, const OrbitalElements &elements, const OrbitBasis &basis, glm::vec4 color=glm::vec4(0, 1, 0, 1)); //Ellipse around `focus`, built on the GPU
+void flush_shapes(float pixels_per_radian, Culler *culler, RenderQueue *queue); //Uploads everything queued since the last flush that `culler` keeps, and adds one draw per kind to `queue`: once per frame. `pixels_per_radian`: at the center of the screen, for the orbits' detail.
+void draw_cubemap(unsigned int cubemap_texture, RenderQueue *queue); //Drawn last, behind everything
 void utils_cleanup();
 
 #endif
\ No newline at end of file